@@ -10,6 +10,7 @@
 #include "iot/thing_manager.h"
 #include "assets/lang_config.h"
 #include "mcp_server.h"
+#include "boot_report.h"
 #include "audio_debugger.h"
 #include "meeting_recorder.h" // <--- 新增
 
@@ -89,6 +90,22 @@ Application::Application() {
     };
     esp_timer_create(&clock_timer_args, &clock_timer_handle_);
 
+    esp_timer_create_args_t abort_timer_args = {
+        .callback = [](void* arg) {
+            Application* app = (Application*)arg;
+            app->OnAbortTimer();
+        },
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "abort_timer",
+        .skip_unhandled_events = true
+    };
+    esp_timer_create(&abort_timer_args, &abort_timer_handle_);
+
+#if CONFIG_USE_IDLE_LISTENING_PM
+    ESP_ERROR_CHECK(esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "audio_active", &pm_lock_));
+#endif
+
     // ==================== 新增：初始化会议记录器 ====================
     meeting_recorder_ = std::make_unique<MeetingRecorder>();
     // ==========================================================
@@ -99,9 +116,18 @@ Application::~Application() {
         esp_timer_stop(clock_timer_handle_);
         esp_timer_delete(clock_timer_handle_);
     }
+    if (abort_timer_handle_ != nullptr) {
+        esp_timer_stop(abort_timer_handle_);
+        esp_timer_delete(abort_timer_handle_);
+    }
     if (background_task_ != nullptr) {
         delete background_task_;
     }
+#if CONFIG_USE_IDLE_LISTENING_PM
+    if (pm_lock_ != nullptr) {
+        esp_pm_lock_delete(pm_lock_);
+    }
+#endif
     vEventGroupDelete(event_group_);
 }
 
@@ -222,6 +248,61 @@ void Application::CheckNewVersion(Ota& ota) {
     }
 }
 
+void Application::CheckNewVersionInBackground() {
+    const int MAX_RETRY = 10;
+    int retry_delay = 10; // 初始重试延迟为10秒
+
+    // 设备已经在使用保存的配置工作，检查失败时不提示用户，只在后台重试
+    auto ota = std::make_shared<Ota>();
+    for (int retry_count = 1; !ota->CheckVersion(); retry_count++) {
+        if (retry_count >= MAX_RETRY) {
+            ESP_LOGE(TAG, "Too many retries, exit background version check");
+            return;
+        }
+        ESP_LOGW(TAG, "Background version check failed, retry in %d seconds (%d/%d)", retry_delay, retry_count, MAX_RETRY);
+        vTaskDelay(pdMS_TO_TICKS(retry_delay * 1000));
+        retry_delay *= 2;
+    }
+
+    if (ota->HasServerTime()) {
+        has_server_time_ = true;
+    }
+    if (!ota->HasNewVersion() && !ota->HasActivationCode() && !ota->HasActivationChallenge()) {
+        // 新的服务器配置已写入设置，下一次会话生效
+        ota->MarkCurrentVersionValid();
+        return;
+    }
+
+    // 升级和激活需要占用屏幕与音频，等对话结束回到空闲后在主循环中处理。
+    // 状态的判断与切换都在主循环中进行，唤醒词与按键不会在中途开始新的对话
+    auto task = xTaskGetCurrentTaskHandle();
+    while (true) {
+        while (device_state_ != kDeviceStateIdle) {
+            vTaskDelay(pdMS_TO_TICKS(1000));
+        }
+        Schedule([this, ota, task]() {
+            if (device_state_ != kDeviceStateIdle || protocol_->IsAudioChannelOpened()) {
+                // 在等待主循环期间又开始了对话，等下一次空闲
+                xTaskNotify(task, 0, eSetValueWithOverwrite);
+                return;
+            }
+            wake_word_->StopDetection();
+            // 有新版本时不会返回，升级完成或失败后都会重启
+            CheckNewVersion(*ota);
+            // 回到空闲时重新开始唤醒词检测；用户按键取消激活时已经回到空闲
+            if (device_state_ == kDeviceStateActivating) {
+                SetDeviceState(kDeviceStateIdle);
+            }
+            xTaskNotify(task, 1, eSetValueWithOverwrite);
+        });
+        uint32_t done = 0;
+        xTaskNotifyWait(0, 0, &done, portMAX_DELAY);
+        if (done) {
+            break;
+        }
+    }
+}
+
 void Application::ShowActivationCode(const std::string& code, const std::string& message) {
     struct digit_sound {
         char digit;
@@ -300,6 +381,7 @@ void Application::PlaySound(const std::string_view& sound) {
         std::lock_guard<std::mutex> lock(mutex_);
         audio_decode_queue_.emplace_back(std::move(packet));
     }
+    NotifyAudioOutput();
 }
 
 void Application::EnterAudioTestingMode() {
@@ -315,6 +397,7 @@ void Application::ExitAudioTestingMode() {
     std::lock_guard<std::mutex> lock(mutex_);
     audio_decode_queue_ = std::move(audio_testing_queue_);
     audio_decode_cv_.notify_all();
+    NotifyAudioOutput();
 }
 
 void Application::ToggleChatState() {
@@ -414,17 +497,46 @@ void Application::StopListening() {
 }
 
 void Application::Start() {
+    auto& boot_report = BootReport::GetInstance();
+    boot_report.Mark("start");
     auto& board = Board::GetInstance();
     SetDeviceState(kDeviceStateStarting);
 
     /* Setup the display */
+    boot_report.Begin("display");
     auto display = board.GetDisplay();
+    boot_report.End("display");
+
+#if CONFIG_USE_IDLE_LISTENING_PM
+    // 最高频率只在持有锁时使用，其余时间动态调频；自动浅睡眠需要 tickless idle，否则整个配置都会被拒绝
+    esp_pm_config_t pm_config = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = 40,
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+        .light_sleep_enable = true,
+#else
+        .light_sleep_enable = false,
+#endif
+    };
+    esp_err_t err = esp_pm_configure(&pm_config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure power management: %s", esp_err_to_name(err));
+    }
+#endif
 
     /* Setup the audio codec */
+    boot_report.Begin("audio_codec");
     auto codec = board.GetAudioCodec();
     opus_decoder_ = std::make_unique<OpusDecoderWrapper>(codec->output_sample_rate(), 1, OPUS_FRAME_DURATION_MS);
     opus_encoder_ = std::make_unique<OpusEncoderWrapper>(16000, 1, OPUS_FRAME_DURATION_MS);
     opus_encoder_->SetComplexity(0);
+#if CONFIG_USE_WAKE_WORD_GATE
+    wake_word_gate_ = std::make_unique<WakeWordGate>(codec->input_channels(), 16000 * CONFIG_WAKE_WORD_GATE_LOOKBACK_MS / 1000);
+    wake_word_gate_->SetThreshold(CONFIG_WAKE_WORD_GATE_RATIO, CONFIG_WAKE_WORD_GATE_MIN_LEVEL);
+#endif
+#if CONFIG_USE_SERVER_AEC
+    playout_timeline_ = std::make_unique<PlayoutTimeline>(16000);
+#endif
     if (aec_mode_ != kAecOff) {
         ESP_LOGI(TAG, "AEC mode: %d, setting opus encoder complexity to 0", aec_mode_);
         opus_encoder_->SetComplexity(0);
@@ -443,6 +555,7 @@ void Application::Start() {
         reference_resampler_.Configure(codec->input_sample_rate(), 16000);
     }
     codec->Start();
+    boot_report.End("audio_codec");
 
 #if CONFIG_USE_AUDIO_PROCESSOR
     xTaskCreatePinnedToCore([](void* arg) {
@@ -450,29 +563,161 @@ void Application::Start() {
         app->AudioLoop();
         vTaskDelete(NULL);
     }, "audio_loop", 4096 * 2, this, 8, &audio_loop_task_handle_, 1);
+    xTaskCreatePinnedToCore([](void* arg) {
+        Application* app = (Application*)arg;
+        app->AudioOutputLoop();
+        vTaskDelete(NULL);
+    }, "audio_output", 4096, this, 8, &audio_output_task_handle_, 1);
 #else
     xTaskCreate([](void* arg) {
         Application* app = (Application*)arg;
         app->AudioLoop();
         vTaskDelete(NULL);
     }, "audio_loop", 4096 * 2, this, 8, &audio_loop_task_handle_);
+    xTaskCreate([](void* arg) {
+        Application* app = (Application*)arg;
+        app->AudioOutputLoop();
+        vTaskDelete(NULL);
+    }, "audio_output", 4096, this, 8, &audio_output_task_handle_);
+#endif
+
+    audio_debugger_ = std::make_unique<AudioDebugger>();
+    audio_processor_->OnOutput([this](std::vector<int16_t>&& data) {
+#ifdef CONFIG_USE_SERVER_AEC
+        // 处理器的输出与输入按采样一一对应，先取标记，丢包时也要消耗对应的采集记录
+        auto tag = playout_timeline_->TakeUplink(data.size(), esp_timer_get_time());
+#endif
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (audio_send_queue_.size() >= MAX_AUDIO_PACKETS_IN_QUEUE) {
+                ESP_LOGW(TAG, "Too many audio packets in queue, drop the newest packet");
+                return;
+            }
+        }
+#ifdef CONFIG_USE_SERVER_AEC
+        background_task_->Schedule([this, tag, data = std::move(data)]() mutable {
+            opus_encoder_->Encode(std::move(data), [this, tag](std::vector<uint8_t>&& opus) {
+                AudioStreamPacket packet;
+                packet.payload = std::move(opus);
+                packet.timestamp = tag.timestamp;
+                packet.loopback_delay = tag.loopback_delay_ms;
+#else
+        background_task_->Schedule([this, data = std::move(data)]() mutable {
+            opus_encoder_->Encode(std::move(data), [this](std::vector<uint8_t>&& opus) {
+                AudioStreamPacket packet;
+                packet.payload = std::move(opus);
+#endif
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (audio_send_queue_.size() >= MAX_AUDIO_PACKETS_IN_QUEUE) {
+                    ESP_LOGW(TAG, "Too many audio packets in queue, drop the oldest packet");
+                    audio_send_queue_.pop_front();
+                }
+                audio_send_queue_.emplace_back(std::move(packet));
+                xEventGroupSetBits(event_group_, SEND_AUDIO_EVENT);
+            });
+        });
+    });
+    audio_processor_->OnVadStateChange([this](bool speaking) {
+        if (device_state_ == kDeviceStateListening) {
+            Schedule([this, speaking]() {
+                if (speaking) {
+                    voice_detected_ = true;
+                } else {
+                    voice_detected_ = false;
+                }
+                auto led = Board::GetInstance().GetLed();
+                led->OnStateChanged();
+            });
+        }
+    });
+
+    wake_word_->OnWakeWordDetected([this](const std::string& wake_word) {
+        Schedule([this, &wake_word]() {
+            if (!protocol_) {
+                return;
+            }
+
+            if (device_state_ == kDeviceStateIdle) {
+                wake_word_->EncodeWakeWordData();
+
+                if (!protocol_->IsAudioChannelOpened()) {
+                    SetDeviceState(kDeviceStateConnecting);
+                    if (!protocol_->OpenAudioChannel()) {
+                        wake_word_->StartDetection();
+                        NotifyAudioInput();
+                        return;
+                    }
+                }
+
+                ESP_LOGI(TAG, "Wake word detected: %s", wake_word.c_str());
+#if CONFIG_USE_AFE_WAKE_WORD
+                AudioStreamPacket packet;
+                // Encode and send the wake word data to the server
+                while (wake_word_->GetWakeWordOpus(packet.payload)) {
+                    protocol_->SendAudio(packet);
+                }
+                // Set the chat state to wake word detected
+                protocol_->SendWakeWordDetected(wake_word);
+#else
+                // Play the pop up sound to indicate the wake word is detected
+                // And wait 60ms to make sure the queue has been processed by audio task
+                ResetDecoder();
+                PlaySound(Lang::Sounds::P3_POPUP);
+                vTaskDelay(pdMS_TO_TICKS(60));
 #endif
+                SetListeningMode(aec_mode_ == kAecOff ? kListeningModeAutoStop : kListeningModeRealtime);
+            } else if (device_state_ == kDeviceStateSpeaking) {
+                AbortSpeaking(kAbortReasonWakeWordDetected);
+            } else if (device_state_ == kDeviceStateActivating) {
+                SetDeviceState(kDeviceStateIdle);
+            }
+        });
+    });
+
+    // 模型加载与网络连接、版本检查互不依赖，放到单独的任务中并行进行
+    xTaskCreate([](void* arg) {
+        Application* app = (Application*)arg;
+        auto codec = Board::GetInstance().GetAudioCodec();
+        BootReport::GetInstance().Begin("audio_models");
+        app->audio_processor_->Initialize(codec);
+        app->wake_word_->Initialize(codec);
+        BootReport::GetInstance().End("audio_models");
+        xEventGroupSetBits(app->event_group_, AUDIO_MODELS_READY_EVENT);
+        vTaskDelete(NULL);
+    }, "load_models", 4096 * 2, this, 4, nullptr);
 
     /* Start the clock timer to update the status bar */
     esp_timer_start_periodic(clock_timer_handle_, 1000000);
 
     /* Wait for the network to be ready */
+    boot_report.Begin("network");
     board.StartNetwork();
+    boot_report.End("network");
 
     // Update the status bar immediately to show the network state
     display->UpdateStatusBar(true);
 
     // Check for new firmware version or get the MQTT broker address
+    // 上次检查成功且已激活时直接使用保存的配置，版本检查放到后台，不阻塞进入空闲
     Ota ota;
-    CheckNewVersion(ota);
+    boot_report.Begin("check_version");
+    if (ota.LoadCachedConfig()) {
+        ESP_LOGI(TAG, "Using cached server config, checking new version in background");
+        xEventGroupSetBits(event_group_, CHECK_NEW_VERSION_DONE_EVENT);
+        xTaskCreate([](void* arg) {
+            Application* app = (Application*)arg;
+            app->CheckNewVersionInBackground();
+            app->check_new_version_task_handle_ = nullptr;
+            vTaskDelete(NULL);
+        }, "check_version", 4096 * 2, this, 2, &check_new_version_task_handle_);
+    } else {
+        CheckNewVersion(ota);
+    }
+    boot_report.End("check_version");
 
     // Initialize the protocol
     display->SetStatus(Lang::Strings::LOADING_PROTOCOL);
+    boot_report.Begin("protocol");
 
     // Add MCP common tools before initializing the protocol
 #if CONFIG_IOT_PROTOCOL_MCP
@@ -488,14 +733,44 @@ void Application::Start() {
         protocol_ = std::make_unique<MqttProtocol>();
     }
 
+#if CONFIG_USE_VISION_STREAMING
+    if (board.GetCamera() != nullptr) {
+        vision_streamer_ = std::make_unique<VisionStreamer>(board.GetCamera());
+        vision_streamer_->OnFrame([this](std::vector<uint8_t>&& jpeg) {
+            // 画面与音频共用同一条连接，统一在主循环中发送
+            Schedule([this, jpeg = std::move(jpeg)]() {
+                auto start_time = esp_timer_get_time();
+                protocol_->SendImage(jpeg);
+                vision_streamer_->ReportFrameSent(jpeg.size(), esp_timer_get_time() - start_time);
+            });
+        });
+    }
+#endif
+
+#if CONFIG_USE_MOTION_WAKE
+    if (board.GetCamera() != nullptr) {
+        motion_wake_ = std::make_unique<MotionWake>(board.GetCamera());
+        motion_wake_->OnMotionDetected([this](int changed_percent) {
+            Schedule([this]() {
+                // 只在空闲时触发，WakeWordInvoke 在其他状态下会打断或结束对话
+                if (device_state_ == kDeviceStateIdle) {
+                    WakeWordInvoke(CONFIG_MOTION_WAKE_WORD);
+                }
+            });
+        });
+    }
+#endif
+
     protocol_->OnNetworkError([this](const std::string& message) {
         SetDeviceState(kDeviceStateIdle);
         Alert(Lang::Strings::ERROR, message.c_str(), "sad", Lang::Sounds::P3_EXCLAMATION);
     });
     protocol_->OnIncomingAudio([this](AudioStreamPacket&& packet) {
         std::lock_guard<std::mutex> lock(mutex_);
-        if (device_state_ == kDeviceStateSpeaking && audio_decode_queue_.size() < MAX_AUDIO_PACKETS_IN_QUEUE) {
+        // 打断后服务器停止发送前到达的音频直接丢弃
+        if (device_state_ == kDeviceStateSpeaking && !aborted_ && audio_decode_queue_.size() < MAX_AUDIO_PACKETS_IN_QUEUE) {
             audio_decode_queue_.emplace_back(std::move(packet));
+            NotifyAudioOutput();
         }
     });
     protocol_->OnAudioChannelOpened([this, codec, &board]() {
@@ -505,6 +780,12 @@ void Application::Start() {
                 protocol_->server_sample_rate(), codec->output_sample_rate());
         }
 
+#if CONFIG_USE_VISION_STREAMING
+        if (vision_streamer_ != nullptr && protocol_->CanStreamVision()) {
+            vision_streamer_->Start();
+        }
+#endif
+
 #if CONFIG_IOT_PROTOCOL_XIAOZHI
         auto& thing_manager = iot::ThingManager::GetInstance();
         protocol_->SendIotDescriptors(thing_manager.GetDescriptorsJson());
@@ -516,6 +797,11 @@ void Application::Start() {
     });
     protocol_->OnAudioChannelClosed([this, &board]() {
         board.SetPowerSaveMode(true);
+#if CONFIG_USE_VISION_STREAMING
+        if (vision_streamer_ != nullptr) {
+            vision_streamer_->Stop();
+        }
+#endif
         Schedule([this]() {
             auto display = Board::GetInstance().GetDisplay();
             display->SetChatMessage("system", "");
@@ -572,7 +858,7 @@ void Application::Start() {
 #if CONFIG_IOT_PROTOCOL_MCP
         } else if (strcmp(type->valuestring, "mcp") == 0) {
             auto payload = cJSON_GetObjectItem(root, "payload");
-            if (cJSON_IsObject(payload)) {
+            if (cJSON_IsObject(payload) || cJSON_IsArray(payload)) {
                 McpServer::GetInstance().ParseMessage(payload);
             }
 #endif
@@ -614,110 +900,23 @@ void Application::Start() {
         }
     });
     bool protocol_started = protocol_->Start();
+    boot_report.End("protocol");
 
-    audio_debugger_ = std::make_unique<AudioDebugger>();
-    audio_processor_->Initialize(codec);
-    audio_processor_->OnOutput([this](std::vector<int16_t>&& data) {
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            if (audio_send_queue_.size() >= MAX_AUDIO_PACKETS_IN_QUEUE) {
-                ESP_LOGW(TAG, "Too many audio packets in queue, drop the newest packet");
-                return;
-            }
-        }
-        background_task_->Schedule([this, data = std::move(data)]() mutable {
-            opus_encoder_->Encode(std::move(data), [this](std::vector<uint8_t>&& opus) {
-                AudioStreamPacket packet;
-                packet.payload = std::move(opus);
-#ifdef CONFIG_USE_SERVER_AEC
-                {
-                    std::lock_guard<std::mutex> lock(timestamp_mutex_);
-                    if (!timestamp_queue_.empty()) {
-                        packet.timestamp = timestamp_queue_.front();
-                        timestamp_queue_.pop_front();
-                    } else {
-                        packet.timestamp = 0;
-                    }
-
-                    if (timestamp_queue_.size() > 3) { // 限制队列长度3
-                        timestamp_queue_.pop_front(); // 该包发送前先出队保持队列长度
-                        return;
-                    }
-                }
-#endif
-                std::lock_guard<std::mutex> lock(mutex_);
-                if (audio_send_queue_.size() >= MAX_AUDIO_PACKETS_IN_QUEUE) {
-                    ESP_LOGW(TAG, "Too many audio packets in queue, drop the oldest packet");
-                    audio_send_queue_.pop_front();
-                }
-                audio_send_queue_.emplace_back(std::move(packet));
-                xEventGroupSetBits(event_group_, SEND_AUDIO_EVENT);
-            });
-        });
-    });
-    audio_processor_->OnVadStateChange([this](bool speaking) {
-        if (device_state_ == kDeviceStateListening) {
-            Schedule([this, speaking]() {
-                if (speaking) {
-                    voice_detected_ = true;
-                } else {
-                    voice_detected_ = false;
-                }
-                auto led = Board::GetInstance().GetLed();
-                led->OnStateChanged();
-            });
-        }
-    });
-
-    wake_word_->Initialize(codec);
-    wake_word_->OnWakeWordDetected([this](const std::string& wake_word) {
-        Schedule([this, &wake_word]() {
-            if (!protocol_) {
-                return;
-            }
-
-            if (device_state_ == kDeviceStateIdle) {
-                wake_word_->EncodeWakeWordData();
-
-                if (!protocol_->IsAudioChannelOpened()) {
-                    SetDeviceState(kDeviceStateConnecting);
-                    if (!protocol_->OpenAudioChannel()) {
-                        wake_word_->StartDetection();
-                        return;
-                    }
-                }
-
-                ESP_LOGI(TAG, "Wake word detected: %s", wake_word.c_str());
-#if CONFIG_USE_AFE_WAKE_WORD
-                AudioStreamPacket packet;
-                // Encode and send the wake word data to the server
-                while (wake_word_->GetWakeWordOpus(packet.payload)) {
-                    protocol_->SendAudio(packet);
-                }
-                // Set the chat state to wake word detected
-                protocol_->SendWakeWordDetected(wake_word);
-#else
-                // Play the pop up sound to indicate the wake word is detected
-                // And wait 60ms to make sure the queue has been processed by audio task
-                ResetDecoder();
-                PlaySound(Lang::Sounds::P3_POPUP);
-                vTaskDelay(pdMS_TO_TICKS(60));
-#endif
-                SetListeningMode(aec_mode_ == kAecOff ? kListeningModeAutoStop : kListeningModeRealtime);
-            } else if (device_state_ == kDeviceStateSpeaking) {
-                AbortSpeaking(kAbortReasonWakeWordDetected);
-            } else if (device_state_ == kDeviceStateActivating) {
-                SetDeviceState(kDeviceStateIdle);
-            }
-        });
-    });
+    // 版本检查与协议初始化期间模型已在后台加载，这里等待加载完成
+    xEventGroupWaitBits(event_group_, AUDIO_MODELS_READY_EVENT, pdFALSE, pdTRUE, portMAX_DELAY);
     wake_word_->StartDetection();
+    NotifyAudioInput();
 
     // Wait for the new version check to finish
     xEventGroupWaitBits(event_group_, CHECK_NEW_VERSION_DONE_EVENT, pdTRUE, pdFALSE, portMAX_DELAY);
     SetDeviceState(kDeviceStateIdle);
+    boot_report.Mark("wake_word_ready");
+    boot_report.Print();
 
-    has_server_time_ = ota.HasServerTime();
+    // 后台版本检查可能已经同步了时间
+    if (ota.HasServerTime()) {
+        has_server_time_ = true;
+    }
     if (protocol_started) {
         std::string message = std::string(Lang::Strings::VERSION) + ota.GetCurrentVersion();
         display->ShowNotification(message.c_str());
@@ -745,6 +944,14 @@ void Application::OnClockTimer() {
         // SystemInfo::PrintTaskCpuUsage(pdMS_TO_TICKS(1000));
         // SystemInfo::PrintTaskList();
         SystemInfo::PrintHeapStats();
+        PrintAudioWakeLatency();
+#if CONFIG_USE_IDLE_LISTENING_PM
+        SystemInfo::PrintDutyCycle();
+#endif
+#if CONFIG_USE_WAKE_WORD_GATE
+        ESP_LOGI(TAG, "Wake word gate passed %lu/%lu chunks, noise floor: %d",
+            (unsigned long)wake_word_gate_->passed_chunks(), (unsigned long)wake_word_gate_->total_chunks(), wake_word_gate_->noise_floor());
+#endif
 
         // If we have synchronized server time, set the status to clock "HH:MM" if the device is idle
         if (has_server_time_) {
@@ -788,6 +995,11 @@ void Application::MainEventLoop() {
                 if (!protocol_->SendAudio(packet)) {
                     break;
                 }
+#if CONFIG_USE_VISION_STREAMING
+                if (vision_streamer_ != nullptr) {
+                    vision_streamer_->ReportAudioSent(packet.payload.size());
+                }
+#endif
             }
         }
 
@@ -804,15 +1016,60 @@ void Application::MainEventLoop() {
 
 // The Audio Loop is used to input and output audio data
 void Application::AudioLoop() {
+    while (true) {
+        // 有模块需要输入时阻塞在 I2S 读取上，由接收 DMA 完成唤醒
+        if (OnAudioInput()) {
+            continue;
+        }
+        // 没有模块需要输入时等待状态变化；需要输入但输入被关闭时按帧长重试
+        bool need_input = wake_word_->IsDetectionRunning() || audio_processor_->IsRunning() ||
+            device_state_ == kDeviceStateAudioTesting;
+        xTaskNotifyWait(0, UINT32_MAX, nullptr, need_input ? pdMS_TO_TICKS(OPUS_FRAME_DURATION_MS) : portMAX_DELAY);
+    }
+}
+
+void Application::AudioOutputLoop() {
     auto codec = Board::GetInstance().GetAudioCodec();
     while (true) {
-        OnAudioInput();
+        // 有新的音频包、上一包开始解码或输出被打开时唤醒；输出打开期间每秒检查一次是否需要关闭
+        uint32_t bits = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &bits, codec->output_enabled() ? pdMS_TO_TICKS(1000) : portMAX_DELAY);
+        if (bits & AUDIO_OUTPUT_EVENT) {
+            output_wake_latency_.Add(esp_timer_get_time() - audio_output_notify_time_);
+        }
         if (codec->output_enabled()) {
             OnAudioOutput();
         }
     }
 }
 
+void Application::NotifyAudioInput() {
+    if (audio_loop_task_handle_ != nullptr) {
+        xTaskNotify(audio_loop_task_handle_, AUDIO_INPUT_EVENT, eSetBits);
+    }
+}
+
+void Application::NotifyAudioOutput() {
+    audio_output_notify_time_ = esp_timer_get_time();
+    if (audio_output_task_handle_ != nullptr) {
+        xTaskNotify(audio_output_task_handle_, AUDIO_OUTPUT_EVENT, eSetBits);
+    }
+}
+
+void Application::PrintAudioWakeLatency() {
+    auto print = [](const char* name, AudioWakeLatency& latency) {
+        uint32_t count = latency.count.exchange(0);
+        int64_t total_us = latency.total_us.exchange(0);
+        int64_t max_us = latency.max_us.exchange(0);
+        if (count > 0) {
+            ESP_LOGI(TAG, "Audio %s wake latency: avg %ld us, max %ld us, %lu wakes",
+                name, (long)(total_us / count), (long)max_us, (unsigned long)count);
+        }
+    };
+    print("input", input_wake_latency_);
+    print("output", output_wake_latency_);
+}
+
 void Application::OnAudioOutput() {
     if (busy_decoding_audio_) {
         return;
@@ -845,25 +1102,54 @@ void Application::OnAudioOutput() {
     busy_decoding_audio_ = true;
     if (!background_task_->Schedule([this, codec, packet = std::move(packet)]() mutable {
         busy_decoding_audio_ = false;
-        if (aborted_) {
+        NotifyAudioOutput();
+        // 打断发生在两帧之间时，上一帧仍在 DMA 中播放，这一帧解码后输出淡出再停止；
+        // 已经淡出过或者已经播空时不再输出
+        if (aborted_ && (abort_faded_ || codec->GetPlayoutPosition(esp_timer_get_time()) == codec->output_frames_written())) {
             return;
         }
 
-        std::vector<int16_t> pcm;
-        if (!opus_decoder_->Decode(std::move(packet.payload), pcm)) {
+        if (!opus_decoder_->Decode(std::move(packet.payload), decode_pcm_)) {
             return;
         }
         // Resample if the sample rate is different
+        auto* pcm = &decode_pcm_;
         if (opus_decoder_->sample_rate() != codec->output_sample_rate()) {
-            int target_size = output_resampler_.GetOutputSamples(pcm.size());
-            std::vector<int16_t> resampled(target_size);
-            output_resampler_.Process(pcm.data(), pcm.size(), resampled.data());
-            pcm = std::move(resampled);
+            int target_size = output_resampler_.GetOutputSamples(decode_pcm_.size());
+            resampled_pcm_.resize(target_size);
+            output_resampler_.Process(decode_pcm_.data(), decode_pcm_.size(), resampled_pcm_.data());
+            pcm = &resampled_pcm_;
+        }
+#ifdef CONFIG_USE_SERVER_AEC
+        // 写入会阻塞到这一帧的大部分已经播放，所以在写入之前记录它在输出流中的位置
+        uint32_t start_position = codec->output_frames_written();
+        playout_timeline_->OnPlayout(start_position + pcm->size(), pcm->size(), codec->output_sample_rate(), packet.timestamp);
+#endif
+        // 按 DMA 缓冲区大小分块写入，写入大部分时间阻塞在等待 DMA 上，
+        // 每块之前检查是否被打断，被打断时只输出几毫秒的淡出，避免突然截断产生爆音
+        size_t chunk_samples = codec->dma_frame_num();
+        size_t written = 0;
+        while (written < pcm->size()) {
+            int16_t* chunk = pcm->data() + written;
+            size_t samples = std::min(chunk_samples, pcm->size() - written);
+            if (aborted_) {
+                size_t fade_samples = std::min(samples, (size_t)(codec->output_sample_rate() * ABORT_FADE_OUT_MS / 1000));
+                for (size_t i = 0; i < fade_samples; i++) {
+                    chunk[i] = (int32_t)chunk[i] * (int32_t)(fade_samples - i) / (int32_t)fade_samples;
+                }
+                codec->OutputData(chunk, fade_samples);
+                written += fade_samples;
+                abort_faded_ = true;
+                break;
+            }
+            codec->OutputData(chunk, samples);
+            written += samples;
         }
-        codec->OutputData(pcm);
 #ifdef CONFIG_USE_SERVER_AEC
-        std::lock_guard<std::mutex> lock(timestamp_mutex_);
-        timestamp_queue_.push_back(packet.timestamp);
+        if (written < pcm->size()) {
+            // 被打断截短的帧，后面的部分不会播放
+            playout_timeline_->Truncate(start_position + written);
+        }
 #endif
         last_output_time_ = std::chrono::steady_clock::now();
     })) {
@@ -871,11 +1157,11 @@ void Application::OnAudioOutput() {
     }
 }
 
-void Application::OnAudioInput() {
+bool Application::OnAudioInput() {
     if (device_state_ == kDeviceStateAudioTesting) {
         if (audio_testing_queue_.size() >= AUDIO_TESTING_MAX_DURATION_MS / OPUS_FRAME_DURATION_MS) {
             ExitAudioTestingMode();
-            return;
+            return true;
         }
         std::vector<int16_t> data;
         int samples = OPUS_FRAME_DURATION_MS * 16000 / 1000;
@@ -890,7 +1176,7 @@ void Application::OnAudioInput() {
                     audio_testing_queue_.push_back(std::move(packet));
                 });
             });
-            return;
+            return true;
         }
     }
 
@@ -899,8 +1185,23 @@ void Application::OnAudioInput() {
         int samples = wake_word_->GetFeedSize();
         if (samples > 0) {
             if (ReadAudio(data, 16000, samples)) {
+#if CONFIG_USE_WAKE_WORD_GATE
+                // 只在待机时门控，说话时仍然持续检测以便打断
+                if (device_state_ == kDeviceStateIdle && !audio_processor_->IsRunning()) {
+                    wake_word_gate_->Feed(data, [this](const std::vector<int16_t>& chunk) {
+                        wake_word_->Feed(chunk);
+                    });
+                    return true;
+                }
+#endif
+#if CONFIG_USE_SHARED_AFE && CONFIG_USE_SERVER_AEC
+                // 共用前端时，唤醒词的输入也是音频处理器的输入
+                if (audio_processor_->IsRunning()) {
+                    MarkCapture(data);
+                }
+#endif
                 wake_word_->Feed(data);
-                return;
+                return true;
             }
         }
     }
@@ -910,14 +1211,33 @@ void Application::OnAudioInput() {
         int samples = audio_processor_->GetFeedSize();
         if (samples > 0) {
             if (ReadAudio(data, 16000, samples)) {
+#if CONFIG_USE_SERVER_AEC
+                MarkCapture(data);
+#endif
                 audio_processor_->Feed(data);
-                return;
+                return true;
             }
         }
     }
 
-    vTaskDelay(pdMS_TO_TICKS(OPUS_FRAME_DURATION_MS / 2));
+    return false;
+}
+
+#if CONFIG_USE_SERVER_AEC
+void Application::MarkCapture(const std::vector<int16_t>& data) {
+    auto codec = Board::GetInstance().GetAudioCodec();
+    uint32_t samples = data.size() / codec->input_channels();
+    int64_t now = esp_timer_get_time();
+    // 读取在最后一个接收 DMA 完成时返回，这一块的第一个采样还要再往前推一块的时长
+    int64_t capture_time = (codec->last_input_dma_time() > 0 ? codec->last_input_dma_time() : now) - (int64_t)samples * 1000000 / 16000;
+    uint32_t playout_timestamp = playout_timeline_->TimestampAt(codec->GetPlayoutPosition(capture_time));
+    uint32_t output_delay_ms = 0;
+    if (codec->output_sample_rate() > 0) {
+        output_delay_ms = (uint64_t)(codec->output_frames_written() - codec->GetPlayoutPosition(now)) * 1000 / codec->output_sample_rate();
+    }
+    playout_timeline_->OnCapture(samples, playout_timestamp, capture_time, output_delay_ms);
 }
+#endif
 
 bool Application::ReadAudio(std::vector<int16_t>& data, int sample_rate, int samples) {
     auto codec = Board::GetInstance().GetAudioCodec();
@@ -958,6 +1278,11 @@ bool Application::ReadAudio(std::vector<int16_t>& data, int sample_rate, int sam
         }
     }
     
+    // 读取在最后一个所需的接收 DMA 完成时返回
+    if (codec->last_input_dma_time() > 0) {
+        input_wake_latency_.Add(esp_timer_get_time() - codec->last_input_dma_time());
+    }
+
     // 音频调试：发送原始音频数据
     if (audio_debugger_) {
         audio_debugger_->Feed(data);
@@ -968,10 +1293,44 @@ bool Application::ReadAudio(std::vector<int16_t>& data, int sample_rate, int sam
 
 void Application::AbortSpeaking(AbortReason reason) {
     ESP_LOGI(TAG, "Abort speaking");
+    abort_start_time_ = esp_timer_get_time();
+    abort_faded_ = false;
     aborted_ = true;
+    {
+        // 丢弃尚未解码的音频，后台任务中正在写入或已排队的解码只再输出一段淡出
+        std::lock_guard<std::mutex> lock(mutex_);
+        audio_decode_queue_.clear();
+    }
+    audio_decode_cv_.notify_all();
+
+    // 排在正在进行的解码之后执行，此时不会再有新的数据写入 I2S，DMA 中剩余的部分播放后自动清零。
+    // 从这里开始轮询播放位置，播放位置追上写入位置的时刻才是扬声器实际静音的时刻
+    background_task_->Schedule([this]() {
+        abort_flush_time_ = esp_timer_get_time();
+        esp_timer_stop(abort_timer_handle_);
+        esp_timer_start_periodic(abort_timer_handle_, ABORT_POLL_INTERVAL_MS * 1000);
+    });
     protocol_->SendAbortSpeaking(reason);
 }
 
+void Application::OnAbortTimer() {
+    auto codec = Board::GetInstance().GetAudioCodec();
+    int64_t now = esp_timer_get_time();
+    bool silent = codec->GetPlayoutPosition(now) == codec->output_frames_written();
+    // 新的播放开始后写入位置会继续前进，超时后放弃这次测量
+    if (!silent && now - abort_flush_time_ < (int64_t)(codec->output_latency_ms() + ABORT_POLL_TIMEOUT_MS) * 1000) {
+        return;
+    }
+    esp_timer_stop(abort_timer_handle_);
+    if (!silent) {
+        ESP_LOGW(TAG, "Abort to silence: playout did not drain within %d ms", codec->output_latency_ms() + ABORT_POLL_TIMEOUT_MS);
+        return;
+    }
+    ESP_LOGI(TAG, "Abort to silence: %ld ms (flush %ld ms + DMA drain %ld ms)",
+        (long)((now - abort_start_time_) / 1000), (long)((abort_flush_time_ - abort_start_time_) / 1000),
+        (long)((now - abort_flush_time_) / 1000));
+}
+
 void Application::SetListeningMode(ListeningMode mode) {
     listening_mode_ = mode;
     SetDeviceState(kDeviceStateListening);
@@ -993,19 +1352,46 @@ void Application::SetDeviceState(DeviceState state) {
     auto display = board.GetDisplay();
     auto led = board.GetLed();
     led->OnStateChanged();
+#if CONFIG_USE_IDLE_LISTENING_PM
+    // 待机监听只需要 I2S 驱动自身的锁，其他状态保持最高频率以保证编解码实时性
+    bool need_lock = state != kDeviceStateIdle;
+    if (need_lock != pm_lock_acquired_) {
+        if (need_lock) {
+            esp_pm_lock_acquire(pm_lock_);
+        } else {
+            esp_pm_lock_release(pm_lock_);
+        }
+        pm_lock_acquired_ = need_lock;
+    }
+#endif
+#if CONFIG_USE_MOTION_WAKE
+    if (motion_wake_ != nullptr) {
+        if (state == kDeviceStateIdle) {
+            motion_wake_->Start();
+        } else {
+            motion_wake_->Stop();
+        }
+    }
+#endif
     switch (state) {
         case kDeviceStateUnknown:
         case kDeviceStateIdle:
             display->SetStatus(Lang::Strings::STANDBY);
             display->SetEmotion("neutral");
             audio_processor_->Stop();
+#if CONFIG_USE_WAKE_WORD_GATE
+            // 回看音频来自上一次待机，不能补发到这一次
+            wake_word_gate_->Reset();
+#endif
             wake_word_->StartDetection();
             break;
         case kDeviceStateConnecting:
             display->SetStatus(Lang::Strings::CONNECTING);
             display->SetEmotion("neutral");
             display->SetChatMessage("system", "");
-            timestamp_queue_.clear();
+#if CONFIG_USE_SERVER_AEC
+            playout_timeline_->Reset();
+#endif
             break;
         case kDeviceStateListening:
             display->SetStatus(Lang::Strings::LISTENING);
@@ -1026,6 +1412,10 @@ void Application::SetDeviceState(DeviceState state) {
                     vTaskDelay(pdMS_TO_TICKS(120));
                 }
                 opus_encoder_->ResetState();
+#if CONFIG_USE_SERVER_AEC
+                // 处理器重新开始时丢弃上次留下的采集记录，保持输入输出的采样对应
+                playout_timeline_->ResetCapture();
+#endif
                 audio_processor_->Start();
                 wake_word_->StopDetection();
             }
@@ -1048,6 +1438,8 @@ void Application::SetDeviceState(DeviceState state) {
             // Do nothing
             break;
     }
+    // 唤醒等待中的输入循环，按新状态决定是否读取
+    NotifyAudioInput();
 }
 
 void Application::ResetDecoder() {
@@ -1058,6 +1450,7 @@ void Application::ResetDecoder() {
     last_output_time_ = std::chrono::steady_clock::now();
     auto codec = Board::GetInstance().GetAudioCodec();
     codec->EnableOutput(true);
+    NotifyAudioOutput();
 }
 
 void Application::SetDecodeSampleRate(int sample_rate, int frame_duration) {
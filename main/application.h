@@ -5,6 +5,7 @@
 #include <freertos/event_groups.h>
 #include <freertos/task.h>
 #include <esp_timer.h>
+#include <esp_pm.h>
 
 #include <string>
 #include <mutex>
@@ -12,6 +13,7 @@
 #include <vector>
 #include <condition_variable>
 #include <memory>
+#include <atomic>
 
 #include <opus_encoder.h>
 #include <opus_decoder.h>
@@ -24,10 +26,42 @@
 #include "wake_word.h"
 #include "audio_debugger.h"
 #include "meeting_recorder.h" // <--- 新增
+#if CONFIG_USE_VISION_STREAMING
+#include "vision_streamer.h"
+#endif
+#if CONFIG_USE_WAKE_WORD_GATE
+#include "wake_word_gate.h"
+#endif
+#if CONFIG_USE_MOTION_WAKE
+#include "motion_wake.h"
+#endif
+#if CONFIG_USE_SERVER_AEC
+#include "playout_timeline.h"
+#endif
 
 #define SCHEDULE_EVENT (1 << 0)
 #define SEND_AUDIO_EVENT (1 << 1)
 #define CHECK_NEW_VERSION_DONE_EVENT (1 << 2)
+#define AUDIO_MODELS_READY_EVENT (1 << 3)
+
+// 音频任务的通知位
+#define AUDIO_INPUT_EVENT (1 << 0)
+#define AUDIO_OUTPUT_EVENT (1 << 1)
+
+// 从事件发生到音频任务开始处理的延迟统计，单位微秒
+struct AudioWakeLatency {
+    std::atomic<uint32_t> count = 0;
+    std::atomic<int64_t> total_us = 0;
+    std::atomic<int64_t> max_us = 0;
+
+    void Add(int64_t us) {
+        count++;
+        total_us += us;
+        int64_t max = max_us;
+        while (us > max && !max_us.compare_exchange_weak(max, us)) {
+        }
+    }
+};
 
 enum AecMode {
     kAecOff,
@@ -52,6 +86,10 @@ enum DeviceState {
 #define OPUS_FRAME_DURATION_MS 60
 #define MAX_AUDIO_PACKETS_IN_QUEUE (2400 / OPUS_FRAME_DURATION_MS)
 #define AUDIO_TESTING_MAX_DURATION_MS 10000
+#define ABORT_FADE_OUT_MS 5
+// 打断后轮询播放位置的间隔，以及超过 DMA 延迟多久仍未播空时放弃测量
+#define ABORT_POLL_INTERVAL_MS 2
+#define ABORT_POLL_TIMEOUT_MS 500
 
 class Application {
 public:
@@ -98,17 +136,37 @@ private:
     std::unique_ptr<AudioProcessor> audio_processor_;
     std::unique_ptr<AudioDebugger> audio_debugger_;
     std::unique_ptr<MeetingRecorder> meeting_recorder_; // <--- 新增
+#if CONFIG_USE_VISION_STREAMING
+    std::unique_ptr<VisionStreamer> vision_streamer_;
+#endif
+#if CONFIG_USE_WAKE_WORD_GATE
+    std::unique_ptr<WakeWordGate> wake_word_gate_;
+#endif
+#if CONFIG_USE_MOTION_WAKE
+    std::unique_ptr<MotionWake> motion_wake_;
+#endif
     std::mutex mutex_;
     std::list<std::function<void()>> main_tasks_;
     std::unique_ptr<Protocol> protocol_;
     EventGroupHandle_t event_group_ = nullptr;
     esp_timer_handle_t clock_timer_handle_ = nullptr;
+    esp_timer_handle_t abort_timer_handle_ = nullptr;
+#if CONFIG_USE_IDLE_LISTENING_PM
+    // 对话期间持有，待机监听时释放，让 CPU 降频
+    esp_pm_lock_handle_t pm_lock_ = nullptr;
+    bool pm_lock_acquired_ = false;
+#endif
     volatile DeviceState device_state_ = kDeviceStateUnknown;
     ListeningMode listening_mode_ = kListeningModeAutoStop;
     AecMode aec_mode_ = kAecOff;
 
     bool has_server_time_ = false;
     bool aborted_ = false;
+    std::atomic<int64_t> abort_start_time_ = 0;
+    // 打断后最后一次写入 I2S 完成的时间，之后只剩 DMA 中的数据在播放
+    std::atomic<int64_t> abort_flush_time_ = 0;
+    // 打断后是否已经输出过淡出，打断时清除，后台任务输出淡出后设置
+    std::atomic<bool> abort_faded_ = false;
     bool voice_detected_ = false;
     bool busy_decoding_audio_ = false;
     int clock_ticks_ = 0;
@@ -116,6 +174,10 @@ private:
 
     // Audio encode / decode
     TaskHandle_t audio_loop_task_handle_ = nullptr;
+    TaskHandle_t audio_output_task_handle_ = nullptr;
+    std::atomic<int64_t> audio_output_notify_time_ = 0;
+    AudioWakeLatency input_wake_latency_;
+    AudioWakeLatency output_wake_latency_;
     BackgroundTask* background_task_ = nullptr;
     std::chrono::steady_clock::time_point last_output_time_;
     std::list<AudioStreamPacket> audio_send_queue_;
@@ -123,9 +185,10 @@ private:
     std::condition_variable audio_decode_cv_;
     std::list<AudioStreamPacket> audio_testing_queue_;
 
-    // 新增：用于维护音频包的timestamp队列
-    std::list<uint32_t> timestamp_queue_;
-    std::mutex timestamp_mutex_;
+#if CONFIG_USE_SERVER_AEC
+    // 按实际播放位置给上行音频打上服务器时间戳
+    std::unique_ptr<PlayoutTimeline> playout_timeline_;
+#endif
 
     std::unique_ptr<OpusEncoderWrapper> opus_encoder_;
     std::unique_ptr<OpusDecoderWrapper> opus_decoder_;
@@ -133,17 +196,29 @@ private:
     OpusResampler input_resampler_;
     OpusResampler reference_resampler_;
     OpusResampler output_resampler_;
+    // 解码与重采样的输出缓冲区，只在后台任务中使用，容量复用后播放时不再分配内存
+    std::vector<int16_t> decode_pcm_;
+    std::vector<int16_t> resampled_pcm_;
 
     void MainEventLoop();
-    void OnAudioInput();
+    bool OnAudioInput();
     void OnAudioOutput();
+    void NotifyAudioInput();
+    void NotifyAudioOutput();
+    void PrintAudioWakeLatency();
+#if CONFIG_USE_SERVER_AEC
+    void MarkCapture(const std::vector<int16_t>& data);
+#endif
     void ResetDecoder();
     void SetDecodeSampleRate(int sample_rate, int frame_duration);
     void CheckNewVersion(Ota& ota);
+    void CheckNewVersionInBackground();
     void ShowActivationCode(const std::string& code, const std::string& message);
     void OnClockTimer();
+    void OnAbortTimer();
     void SetListeningMode(ListeningMode mode);
     void AudioLoop();
+    void AudioOutputLoop();
     void EnterAudioTestingMode();
     void ExitAudioTestingMode();
 };
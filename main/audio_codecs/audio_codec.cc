@@ -3,19 +3,39 @@
 #include "settings.h"
 
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <cstring>
+#include <algorithm>
 #include <driver/i2s_common.h>
 
 #define TAG "AudioCodec"
 
+// DMA 描述符数量与每个描述符帧数的有效范围
+#define MIN_DMA_DESC_NUM 2
+#define MAX_DMA_DESC_NUM 16
+#define MIN_DMA_FRAME_NUM 32
+#define MAX_DMA_FRAME_NUM 1023
+
 AudioCodec::AudioCodec() {
+    Settings settings("audio", false);
+    dma_desc_num_ = std::clamp<int>(settings.GetInt("dma_desc_num", AUDIO_CODEC_DMA_DESC_NUM), MIN_DMA_DESC_NUM, MAX_DMA_DESC_NUM);
+    dma_frame_num_ = std::clamp<int>(settings.GetInt("dma_frame_num", AUDIO_CODEC_DMA_FRAME_NUM), MIN_DMA_FRAME_NUM, MAX_DMA_FRAME_NUM);
 }
 
 AudioCodec::~AudioCodec() {
 }
 
 void AudioCodec::OutputData(std::vector<int16_t>& data) {
-    Write(data.data(), data.size());
+    OutputData(data.data(), data.size());
+}
+
+void AudioCodec::OutputData(const int16_t* data, int samples) {
+    if (output_frames_played_ == output_frames_written_) {
+        // 已经播空时，新数据写在正在发送的缓冲区之后，下一次发送完成的仍是静音
+        output_skip_buffers_ = 1;
+    }
+    Write(data, samples);
+    output_frames_written_ = output_frames_written_ + samples;
 }
 
 bool AudioCodec::InputData(std::vector<int16_t>& data) {
@@ -34,12 +54,78 @@ void AudioCodec::Start() {
         output_volume_ = 10;
     }
 
+    // 记录接收 DMA 的完成时间，用于统计音频任务被唤醒到处理数据的延迟，回调必须在启用通道前注册
+    i2s_event_callbacks_t rx_callbacks = {};
+    rx_callbacks.on_recv = [](i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx) -> bool {
+        auto codec = (AudioCodec*)user_ctx;
+        codec->last_input_dma_time_ = esp_timer_get_time();
+        return false;
+    };
+    i2s_channel_register_event_callback(rx_handle_, &rx_callbacks, this);
+
+    // 记录发送 DMA 的进度，得到扬声器实际播放到的位置
+    i2s_event_callbacks_t tx_callbacks = {};
+    tx_callbacks.on_sent = [](i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx) -> bool {
+        auto codec = (AudioCodec*)user_ctx;
+        codec->last_output_dma_time_ = esp_timer_get_time();
+        if (codec->output_skip_buffers_ > 0) {
+            codec->output_skip_buffers_ = codec->output_skip_buffers_ - 1;
+            return false;
+        }
+        uint32_t pending = codec->output_frames_written_ - codec->output_frames_played_;
+        codec->output_frames_played_ = codec->output_frames_played_ + std::min(pending, codec->dma_frame_num_);
+        return false;
+    };
+    i2s_channel_register_event_callback(tx_handle_, &tx_callbacks, this);
+
     ESP_ERROR_CHECK(i2s_channel_enable(tx_handle_));
     ESP_ERROR_CHECK(i2s_channel_enable(rx_handle_));
 
     EnableInput(true);
     EnableOutput(true);
-    ESP_LOGI(TAG, "Audio codec started");
+    ESP_LOGI(TAG, "Audio codec started, DMA depth: %lu x %lu frames, output latency: %d ms",
+        (unsigned long)dma_desc_num_, (unsigned long)dma_frame_num_, output_latency_ms());
+}
+
+void AudioCodec::SetDmaDepth(int desc_num, int frame_num) {
+    desc_num = std::clamp(desc_num, MIN_DMA_DESC_NUM, MAX_DMA_DESC_NUM);
+    frame_num = std::clamp(frame_num, MIN_DMA_FRAME_NUM, MAX_DMA_FRAME_NUM);
+    ESP_LOGI(TAG, "Set DMA depth to %d x %d frames, takes effect after restart", desc_num, frame_num);
+
+    Settings settings("audio", true);
+    settings.SetInt("dma_desc_num", desc_num);
+    settings.SetInt("dma_frame_num", frame_num);
+}
+
+void AudioCodec::ResetDmaDepth() {
+    ESP_LOGI(TAG, "Reset DMA depth to %d x %d frames, takes effect after restart", AUDIO_CODEC_DMA_DESC_NUM, AUDIO_CODEC_DMA_FRAME_NUM);
+
+    Settings settings("audio", true);
+    settings.EraseKey("dma_desc_num");
+    settings.EraseKey("dma_frame_num");
+}
+
+uint32_t AudioCodec::GetPlayoutPosition(int64_t time) const {
+    uint32_t written = output_frames_written_;
+    uint32_t played = output_frames_played_;
+    int64_t last_dma_time = last_output_dma_time_;
+    if (last_dma_time == 0 || output_sample_rate_ <= 0) {
+        // 没有发送回调时只能认为写入即播放
+        return written;
+    }
+
+    // 在两次发送完成之间按时间插值，向后不超过正在发送的缓冲区
+    int64_t frames = (time - last_dma_time) * output_sample_rate_ / 1000000;
+    int64_t max_frames = output_skip_buffers_ > 0 ? 0 : std::min<uint32_t>(dma_frame_num_, written - played);
+    frames = std::clamp<int64_t>(frames, -(int64_t)played, max_frames);
+    return played + frames;
+}
+
+int AudioCodec::output_latency_ms() const {
+    if (output_sample_rate_ <= 0) {
+        return 0;
+    }
+    return dma_desc_num_ * dma_frame_num_ * 1000 / output_sample_rate_;
 }
 
 void AudioCodec::SetOutputVolume(int volume) {
@@ -63,5 +149,8 @@ void AudioCodec::EnableOutput(bool enable) {
         return;
     }
     output_enabled_ = enable;
+    // 子类可能会停止发送通道，切换时认为已写入的数据都已播放
+    output_skip_buffers_ = 0;
+    output_frames_played_ = output_frames_written_;
     ESP_LOGI(TAG, "Set output enable to %s", enable ? "true" : "false");
 }
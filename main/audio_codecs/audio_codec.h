@@ -11,8 +11,9 @@
 
 #include "board.h"
 
-#define AUDIO_CODEC_DMA_DESC_NUM 6
-#define AUDIO_CODEC_DMA_FRAME_NUM 240
+// DMA 深度的默认值，由 Kconfig 中的缓冲模式决定
+#define AUDIO_CODEC_DMA_DESC_NUM CONFIG_AUDIO_CODEC_DMA_DESC_NUM
+#define AUDIO_CODEC_DMA_FRAME_NUM CONFIG_AUDIO_CODEC_DMA_FRAME_NUM
 #define AUDIO_CODEC_DEFAULT_MIC_GAIN 30.0
 
 class AudioCodec {
@@ -24,7 +25,14 @@ public:
     virtual void EnableInput(bool enable);
     virtual void EnableOutput(bool enable);
 
+    // 保存新的 DMA 深度，在下次创建 I2S 通道（即重启）后生效
+    void SetDmaDepth(int desc_num, int frame_num);
+    // 清除保存的 DMA 深度，重启后恢复 Kconfig 中按会话模式选择的默认值
+    void ResetDmaDepth();
+
     virtual void OutputData(std::vector<int16_t>& data);
+    // 写入一段输出数据，可用于分块写入以便在块之间停止
+    void OutputData(const int16_t* data, int samples);
     virtual bool InputData(std::vector<int16_t>& data);
     virtual void Start();
 
@@ -42,6 +50,16 @@ public:
     inline int output_volume() const { return output_volume_; }
     inline bool input_enabled() const { return input_enabled_; }
     inline bool output_enabled() const { return output_enabled_; }
+    inline int dma_desc_num() const { return dma_desc_num_; }
+    inline int dma_frame_num() const { return dma_frame_num_; }
+    // 输出 DMA 缓冲区全部填满时的播放延迟
+    int output_latency_ms() const;
+    // 最近一次 I2S 接收 DMA 完成的时间（esp_timer 微秒），未注册回调时为 0
+    inline int64_t last_input_dma_time() const { return last_input_dma_time_; }
+    // 通过 OutputData 写入的累计帧数（每声道采样数）
+    inline uint32_t output_frames_written() const { return output_frames_written_; }
+    // time 时刻（esp_timer 微秒）实际由发送 DMA 送出的累计帧数，与 output_frames_written 使用同一计数
+    uint32_t GetPlayoutPosition(int64_t time) const;
 
 protected:
     i2s_chan_handle_t tx_handle_ = nullptr;
@@ -56,6 +74,15 @@ protected:
     int input_channels_ = 1;
     int output_channels_ = 1;
     int output_volume_ = 70;
+    // 子类创建 I2S 通道时使用，构造时从设置中读取
+    uint32_t dma_desc_num_ = AUDIO_CODEC_DMA_DESC_NUM;
+    uint32_t dma_frame_num_ = AUDIO_CODEC_DMA_FRAME_NUM;
+    volatile int64_t last_input_dma_time_ = 0;
+    // 播放位置：发送 DMA 每送出一个缓冲区就前进一个缓冲区的帧数，但不超过已写入的帧数
+    volatile uint32_t output_frames_written_ = 0;
+    volatile uint32_t output_frames_played_ = 0;
+    volatile int output_skip_buffers_ = 0;
+    volatile int64_t last_output_dma_time_ = 0;
 
     virtual int Read(int16_t* dest, int samples) = 0;
     virtual int Write(const int16_t* data, int samples) = 0;
@@ -8,6 +8,10 @@
 
 class NoAudioCodec : public AudioCodec {
 private:
+    // 转换为 32 位样本的暂存区，放在可 DMA 的内部 RAM 中并复用，播放时不再逐帧分配
+    int32_t* output_buffer_ = nullptr;
+    int output_buffer_samples_ = 0;
+
     virtual int Write(const int16_t* data, int samples) override;
     virtual int Read(int16_t* dest, int samples) override;
 
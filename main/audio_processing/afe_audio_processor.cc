@@ -1,4 +1,9 @@
 #include "afe_audio_processor.h"
+#include "sr_models.h"
+#if CONFIG_USE_SHARED_AFE
+#include "afe_front_end.h"
+#endif
+
 #include <esp_log.h>
 
 #define PROCESSOR_RUNNING 0x01
@@ -12,6 +17,19 @@ AfeAudioProcessor::AfeAudioProcessor()
 
 void AfeAudioProcessor::Initialize(AudioCodec* codec) {
     codec_ = codec;
+
+#if CONFIG_USE_SHARED_AFE
+    // 与唤醒词共用同一个 AFE，由 AfeFrontEnd 的任务分发输出
+    auto& front_end = AfeFrontEnd::GetInstance();
+    if (!front_end.Initialize(codec_)) {
+        return;
+    }
+    afe_iface_ = front_end.afe_iface();
+    afe_data_ = front_end.afe_data();
+    front_end.OnOutput(kAfeConsumerProcessor, [this](afe_fetch_result_t* res) {
+        HandleFetchResult(res);
+    });
+#else
     int ref_num = codec_->input_reference() ? 1 : 0;
 
     std::string input_format;
@@ -22,9 +40,9 @@ void AfeAudioProcessor::Initialize(AudioCodec* codec) {
         input_format.push_back('R');
     }
 
-    srmodel_list_t *models = esp_srmodel_init("model");
-    char* ns_model_name = esp_srmodel_filter(models, ESP_NSNET_PREFIX, NULL);
-    char* vad_model_name = esp_srmodel_filter(models, ESP_VADN_PREFIX, NULL);
+    auto& sr_models = SrModels::GetInstance();
+    char* ns_model_name = sr_models.Filter(ESP_NSNET_PREFIX);
+    char* vad_model_name = sr_models.Filter(ESP_VADN_PREFIX);
     
     afe_config_t* afe_config = afe_config_init(input_format.c_str(), NULL, AFE_TYPE_VC, AFE_MODE_HIGH_PERF);
     afe_config->aec_mode = AEC_MODE_VOIP_HIGH_PERF;
@@ -63,12 +81,15 @@ void AfeAudioProcessor::Initialize(AudioCodec* codec) {
         this_->AudioProcessorTask();
         vTaskDelete(NULL);
     }, "audio_communication", 4096, this, 3, NULL);
+#endif
 }
 
 AfeAudioProcessor::~AfeAudioProcessor() {
+#if !CONFIG_USE_SHARED_AFE
     if (afe_data_ != nullptr) {
         afe_iface_->destroy(afe_data_);
     }
+#endif
     vEventGroupDelete(event_group_);
 }
 
@@ -88,13 +109,20 @@ void AfeAudioProcessor::Feed(const std::vector<int16_t>& data) {
 
 void AfeAudioProcessor::Start() {
     xEventGroupSetBits(event_group_, PROCESSOR_RUNNING);
+#if CONFIG_USE_SHARED_AFE
+    AfeFrontEnd::GetInstance().Start(kAfeConsumerProcessor);
+#endif
 }
 
 void AfeAudioProcessor::Stop() {
     xEventGroupClearBits(event_group_, PROCESSOR_RUNNING);
+#if CONFIG_USE_SHARED_AFE
+    AfeFrontEnd::GetInstance().Stop(kAfeConsumerProcessor);
+#else
     if (afe_data_ != nullptr) {
         afe_iface_->reset_buffer(afe_data_);
     }
+#endif
 }
 
 bool AfeAudioProcessor::IsRunning() {
@@ -128,21 +156,24 @@ void AfeAudioProcessor::AudioProcessorTask() {
             }
             continue;
         }
+        HandleFetchResult(res);
+    }
+}
 
-        // VAD state change
-        if (vad_state_change_callback_) {
-            if (res->vad_state == VAD_SPEECH && !is_speaking_) {
-                is_speaking_ = true;
-                vad_state_change_callback_(true);
-            } else if (res->vad_state == VAD_SILENCE && is_speaking_) {
-                is_speaking_ = false;
-                vad_state_change_callback_(false);
-            }
+void AfeAudioProcessor::HandleFetchResult(afe_fetch_result_t* res) {
+    // VAD state change
+    if (vad_state_change_callback_) {
+        if (res->vad_state == VAD_SPEECH && !is_speaking_) {
+            is_speaking_ = true;
+            vad_state_change_callback_(true);
+        } else if (res->vad_state == VAD_SILENCE && is_speaking_) {
+            is_speaking_ = false;
+            vad_state_change_callback_(false);
         }
+    }
 
-        if (output_callback_) {
-            output_callback_(std::vector<int16_t>(res->data, res->data + res->data_size / sizeof(int16_t)));
-        }
+    if (output_callback_) {
+        output_callback_(std::vector<int16_t>(res->data, res->data + res->data_size / sizeof(int16_t)));
     }
 }
 
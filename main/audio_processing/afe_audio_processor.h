@@ -38,6 +38,7 @@ private:
     bool is_speaking_ = false;
 
     void AudioProcessorTask();
+    void HandleFetchResult(afe_fetch_result_t* res);
 };
 
 #endif 
\ No newline at end of file
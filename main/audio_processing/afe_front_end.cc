@@ -0,0 +1,145 @@
+#include "afe_front_end.h"
+#include "sr_models.h"
+
+#include <esp_log.h>
+#include <string>
+
+#define ALL_CONSUMERS (kAfeConsumerWakeWord | kAfeConsumerProcessor)
+
+#define TAG "AfeFrontEnd"
+
+AfeFrontEnd::AfeFrontEnd() {
+    event_group_ = xEventGroupCreate();
+}
+
+AfeFrontEnd::~AfeFrontEnd() {
+    if (afe_data_ != nullptr) {
+        afe_iface_->destroy(afe_data_);
+    }
+    vEventGroupDelete(event_group_);
+}
+
+bool AfeFrontEnd::Initialize(AudioCodec* codec) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (afe_data_ != nullptr) {
+        return true;
+    }
+
+    auto& sr_models = SrModels::GetInstance();
+    srmodel_list_t* models = sr_models.Get();
+    if (models == nullptr) {
+        return false;
+    }
+
+    int ref_num = codec->input_reference() ? 1 : 0;
+    std::string input_format;
+    for (int i = 0; i < codec->input_channels() - ref_num; i++) {
+        input_format.push_back('M');
+    }
+    for (int i = 0; i < ref_num; i++) {
+        input_format.push_back('R');
+    }
+
+    // 以识别模式创建，保证 WakeNet 可用，同时打开上行需要的 NS 与 VAD
+    afe_config_t* afe_config = afe_config_init(input_format.c_str(), models, AFE_TYPE_SR, AFE_MODE_HIGH_PERF);
+    afe_config->aec_init = codec->input_reference();
+    afe_config->aec_mode = AEC_MODE_SR_HIGH_PERF;
+    afe_config->vad_init = true;
+    afe_config->vad_mode = VAD_MODE_0;
+    afe_config->vad_min_noise_ms = 100;
+    char* vad_model_name = sr_models.Filter(ESP_VADN_PREFIX);
+    if (vad_model_name != nullptr) {
+        afe_config->vad_model_name = vad_model_name;
+    }
+    char* ns_model_name = sr_models.Filter(ESP_NSNET_PREFIX);
+    if (ns_model_name != nullptr) {
+        afe_config->ns_init = true;
+        afe_config->ns_model_name = ns_model_name;
+        afe_config->afe_ns_mode = AFE_NS_MODE_NET;
+    } else {
+        afe_config->ns_init = false;
+    }
+    afe_config->agc_init = false;
+    afe_config->afe_perferred_core = 1;
+    afe_config->afe_perferred_priority = 1;
+    afe_config->memory_alloc_mode = AFE_MEMORY_ALLOC_MORE_PSRAM;
+
+    afe_iface_ = esp_afe_handle_from_config(afe_config);
+    afe_data_ = afe_iface_->create_from_config(afe_config);
+    if (afe_data_ == nullptr) {
+        ESP_LOGE(TAG, "Failed to create AFE");
+        return false;
+    }
+    // 只有唤醒词在运行时才需要 WakeNet
+    afe_iface_->disable_wakenet(afe_data_);
+
+    xTaskCreate([](void* arg) {
+        auto this_ = (AfeFrontEnd*)arg;
+        this_->FetchTask();
+        vTaskDelete(NULL);
+    }, "afe_front_end", 4096, this, 3, nullptr);
+    return true;
+}
+
+void AfeFrontEnd::OnOutput(AfeConsumer consumer, std::function<void(afe_fetch_result_t* result)> callback) {
+    if (consumer == kAfeConsumerWakeWord) {
+        wake_word_callback_ = callback;
+    } else {
+        processor_callback_ = callback;
+    }
+}
+
+void AfeFrontEnd::Start(AfeConsumer consumer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (afe_data_ == nullptr) {
+        return;
+    }
+    auto bits = xEventGroupGetBits(event_group_);
+    if (consumer == kAfeConsumerWakeWord && !(bits & kAfeConsumerWakeWord)) {
+        afe_iface_->enable_wakenet(afe_data_);
+    }
+    xEventGroupSetBits(event_group_, consumer);
+}
+
+void AfeFrontEnd::Stop(AfeConsumer consumer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (afe_data_ == nullptr) {
+        return;
+    }
+    auto bits = xEventGroupClearBits(event_group_, consumer);
+    if (consumer == kAfeConsumerWakeWord && (bits & kAfeConsumerWakeWord)) {
+        afe_iface_->disable_wakenet(afe_data_);
+    }
+    // 还有其他使用者时保留缓冲区，避免切换时丢失音频
+    if ((bits & ALL_CONSUMERS & ~consumer) == 0) {
+        afe_iface_->reset_buffer(afe_data_);
+    }
+}
+
+void AfeFrontEnd::FetchTask() {
+    auto fetch_size = afe_iface_->get_fetch_chunksize(afe_data_);
+    auto feed_size = afe_iface_->get_feed_chunksize(afe_data_);
+    ESP_LOGI(TAG, "AFE front end task started, feed size: %d fetch size: %d",
+        feed_size, fetch_size);
+
+    while (true) {
+        xEventGroupWaitBits(event_group_, ALL_CONSUMERS, pdFALSE, pdFALSE, portMAX_DELAY);
+
+        auto res = afe_iface_->fetch_with_delay(afe_data_, portMAX_DELAY);
+        if (res == nullptr || res->ret_value == ESP_FAIL) {
+            if (res != nullptr) {
+                ESP_LOGI(TAG, "Error code: %d", res->ret_value);
+            }
+            continue;
+        }
+
+        // 使用者可能在 fetch 期间停止，按当前状态分发
+        auto bits = xEventGroupGetBits(event_group_);
+        if ((bits & kAfeConsumerProcessor) && processor_callback_) {
+            processor_callback_(res);
+        }
+        if ((bits & kAfeConsumerWakeWord) && wake_word_callback_) {
+            wake_word_callback_(res);
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef AFE_FRONT_END_H
+#define AFE_FRONT_END_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/event_groups.h>
+
+#include <esp_afe_sr_models.h>
+
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "audio_codec.h"
+
+enum AfeConsumer {
+    kAfeConsumerWakeWord = 1 << 0,
+    kAfeConsumerProcessor = 1 << 1,
+};
+
+// 唤醒词与音频处理共用的 AFE（AEC/NS/VAD/WakeNet），只有一个实例和一个 fetch 任务，
+// 每帧输出分发给所有正在运行的使用者。只要还有使用者在运行就不会重置缓冲区，
+// 从待机切换到聆听时音频是连续的
+class AfeFrontEnd {
+public:
+    static AfeFrontEnd& GetInstance() {
+        static AfeFrontEnd instance;
+        return instance;
+    }
+    // Delete copy constructor and assignment operator
+    AfeFrontEnd(const AfeFrontEnd&) = delete;
+    AfeFrontEnd& operator=(const AfeFrontEnd&) = delete;
+
+    // 每个使用者都会调用，只有第一次会创建 AFE
+    bool Initialize(AudioCodec* codec);
+    void OnOutput(AfeConsumer consumer, std::function<void(afe_fetch_result_t* result)> callback);
+    void Start(AfeConsumer consumer);
+    void Stop(AfeConsumer consumer);
+
+    esp_afe_sr_iface_t* afe_iface() const { return afe_iface_; }
+    esp_afe_sr_data_t* afe_data() const { return afe_data_; }
+
+private:
+    AfeFrontEnd();
+    ~AfeFrontEnd();
+
+    std::mutex mutex_;
+    EventGroupHandle_t event_group_ = nullptr;
+    esp_afe_sr_iface_t* afe_iface_ = nullptr;
+    esp_afe_sr_data_t* afe_data_ = nullptr;
+    std::function<void(afe_fetch_result_t* result)> wake_word_callback_;
+    std::function<void(afe_fetch_result_t* result)> processor_callback_;
+
+    void FetchTask();
+};
+
+#endif // AFE_FRONT_END_H
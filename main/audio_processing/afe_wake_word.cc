@@ -1,5 +1,9 @@
 #include "afe_wake_word.h"
 #include "application.h"
+#include "sr_models.h"
+#if CONFIG_USE_SHARED_AFE
+#include "afe_front_end.h"
+#endif
 
 #include <esp_log.h>
 #include <model_path.h>
@@ -8,21 +12,32 @@
 
 #define DETECTION_RUNNING_EVENT 1
 
+// 持续编码任务的通知位
+#define ENCODE_PCM_EVENT (1 << 0)
+#define ENCODE_FLUSH_EVENT (1 << 1)
+#define ENCODE_TASK_STACK_SIZE (4096 * 8)
+
 #define TAG "AfeWakeWord"
 
 AfeWakeWord::AfeWakeWord()
     : afe_data_(nullptr),
-      wake_word_pcm_(),
       wake_word_opus_() {
 
     event_group_ = xEventGroupCreate();
 }
 
 AfeWakeWord::~AfeWakeWord() {
+#if !CONFIG_USE_SHARED_AFE
     if (afe_data_ != nullptr) {
         afe_iface_->destroy(afe_data_);
     }
+#endif
 
+#if CONFIG_AFE_WAKE_WORD_CONTINUOUS_ENCODE
+    if (wake_word_encode_task_ != nullptr) {
+        vTaskDelete(wake_word_encode_task_);
+    }
+#endif
     if (wake_word_encode_task_stack_ != nullptr) {
         heap_caps_free(wake_word_encode_task_stack_);
     }
@@ -32,15 +47,13 @@ AfeWakeWord::~AfeWakeWord() {
 
 void AfeWakeWord::Initialize(AudioCodec* codec) {
     codec_ = codec;
-    int ref_num = codec_->input_reference() ? 1 : 0;
 
-    srmodel_list_t *models = esp_srmodel_init("model");
-    if (models == nullptr || models->num == -1) {
+    srmodel_list_t *models = SrModels::GetInstance().Get();
+    if (models == nullptr) {
         ESP_LOGE(TAG, "Failed to initialize wakenet model");
         return;
     }
     for (int i = 0; i < models->num; i++) {
-        ESP_LOGI(TAG, "Model %d: %s", i, models->model_name[i]);
         if (strstr(models->model_name[i], ESP_WN_PREFIX) != NULL) {
             wakenet_model_ = models->model_name[i];
             auto words = esp_srmodel_get_wake_words(models, wakenet_model_);
@@ -53,6 +66,19 @@ void AfeWakeWord::Initialize(AudioCodec* codec) {
         }
     }
 
+#if CONFIG_USE_SHARED_AFE
+    // 与音频处理共用同一个 AFE，由 AfeFrontEnd 的任务分发输出
+    auto& front_end = AfeFrontEnd::GetInstance();
+    if (!front_end.Initialize(codec_)) {
+        return;
+    }
+    afe_iface_ = front_end.afe_iface();
+    afe_data_ = front_end.afe_data();
+    front_end.OnOutput(kAfeConsumerWakeWord, [this](afe_fetch_result_t* res) {
+        HandleFetchResult(res);
+    });
+#else
+    int ref_num = codec_->input_reference() ? 1 : 0;
     std::string input_format;
     for (int i = 0; i < codec_->input_channels() - ref_num; i++) {
         input_format.push_back('M');
@@ -69,12 +95,29 @@ void AfeWakeWord::Initialize(AudioCodec* codec) {
     
     afe_iface_ = esp_afe_handle_from_config(afe_config);
     afe_data_ = afe_iface_->create_from_config(afe_config);
+#endif
+
+    // AFE 输出为 16kHz 单声道
+    wake_word_pcm_ = std::make_unique<PcmRingBuffer>(16000 * CONFIG_AFE_WAKE_WORD_PREROLL_MS / 1000);
 
+#if CONFIG_AFE_WAKE_WORD_CONTINUOUS_ENCODE
+    // 检测期间在另一个核上持续编码预录音频，检测到唤醒词时 Opus 包已经就绪
+    preroll_opus_.resize(CONFIG_AFE_WAKE_WORD_PREROLL_MS / OPUS_FRAME_DURATION_MS);
+    wake_word_encode_task_stack_ = (StackType_t*)heap_caps_malloc(ENCODE_TASK_STACK_SIZE, MALLOC_CAP_SPIRAM);
+    wake_word_encode_task_ = xTaskCreateStaticPinnedToCore([](void* arg) {
+        auto this_ = (AfeWakeWord*)arg;
+        this_->ContinuousEncodeTask();
+        vTaskDelete(NULL);
+    }, "wake_word_encode", ENCODE_TASK_STACK_SIZE, this, 1, wake_word_encode_task_stack_, &wake_word_encode_task_buffer_, 0);
+#endif
+
+#if !CONFIG_USE_SHARED_AFE
     xTaskCreate([](void* arg) {
         auto this_ = (AfeWakeWord*)arg;
         this_->AudioDetectionTask();
         vTaskDelete(NULL);
     }, "audio_detection", 4096, this, 3, nullptr);
+#endif
 }
 
 void AfeWakeWord::OnWakeWordDetected(std::function<void(const std::string& wake_word)> callback) {
@@ -83,13 +126,20 @@ void AfeWakeWord::OnWakeWordDetected(std::function<void(const std::string& wake_
 
 void AfeWakeWord::StartDetection() {
     xEventGroupSetBits(event_group_, DETECTION_RUNNING_EVENT);
+#if CONFIG_USE_SHARED_AFE
+    AfeFrontEnd::GetInstance().Start(kAfeConsumerWakeWord);
+#endif
 }
 
 void AfeWakeWord::StopDetection() {
     xEventGroupClearBits(event_group_, DETECTION_RUNNING_EVENT);
+#if CONFIG_USE_SHARED_AFE
+    AfeFrontEnd::GetInstance().Stop(kAfeConsumerWakeWord);
+#else
     if (afe_data_ != nullptr) {
         afe_iface_->reset_buffer(afe_data_);
     }
+#endif
 }
 
 bool AfeWakeWord::IsDetectionRunning() {
@@ -123,34 +173,44 @@ void AfeWakeWord::AudioDetectionTask() {
         if (res == nullptr || res->ret_value == ESP_FAIL) {
             continue;;
         }
+        HandleFetchResult(res);
+    }
+}
 
-        // Store the wake word data for voice recognition, like who is speaking
-        StoreWakeWordData(res->data, res->data_size / sizeof(int16_t));
+void AfeWakeWord::HandleFetchResult(afe_fetch_result_t* res) {
+    // Store the wake word data for voice recognition, like who is speaking
+    StoreWakeWordData(res->data, res->data_size / sizeof(int16_t));
 
-        if (res->wakeup_state == WAKENET_DETECTED) {
-            StopDetection();
-            last_detected_wake_word_ = wake_words_[res->wake_word_index - 1];
+    if (res->wakeup_state == WAKENET_DETECTED) {
+        StopDetection();
+        last_detected_wake_word_ = wake_words_[res->wake_word_index - 1];
 
-            if (wake_word_detected_callback_) {
-                wake_word_detected_callback_(last_detected_wake_word_);
-            }
+        if (wake_word_detected_callback_) {
+            wake_word_detected_callback_(last_detected_wake_word_);
         }
     }
 }
 
 void AfeWakeWord::StoreWakeWordData(const int16_t* data, size_t samples) {
-    // store audio data to wake_word_pcm_
-    wake_word_pcm_.emplace_back(std::vector<int16_t>(data, data + samples));
-    // keep about 2 seconds of data, detect duration is 30ms (sample_rate == 16000, chunksize == 512)
-    while (wake_word_pcm_.size() > 2000 / 30) {
-        wake_word_pcm_.pop_front();
-    }
+    // 写入预先分配的环形缓冲区，持续监听时不产生堆分配
+    wake_word_pcm_->Write(data, samples);
+#if CONFIG_AFE_WAKE_WORD_CONTINUOUS_ENCODE
+    xTaskNotify(wake_word_encode_task_, ENCODE_PCM_EVENT, eSetBits);
+#endif
 }
 
 void AfeWakeWord::EncodeWakeWordData() {
+#if CONFIG_AFE_WAKE_WORD_CONTINUOUS_ENCODE
+    {
+        std::lock_guard<std::mutex> lock(wake_word_mutex_);
+        wake_word_opus_.clear();
+    }
+    // 编码任务只需补完最后不足一帧的数据，然后发布已经编码好的包
+    xTaskNotify(wake_word_encode_task_, ENCODE_FLUSH_EVENT, eSetBits);
+#else
     wake_word_opus_.clear();
     if (wake_word_encode_task_stack_ == nullptr) {
-        wake_word_encode_task_stack_ = (StackType_t*)heap_caps_malloc(4096 * 8, MALLOC_CAP_SPIRAM);
+        wake_word_encode_task_stack_ = (StackType_t*)heap_caps_malloc(ENCODE_TASK_STACK_SIZE, MALLOC_CAP_SPIRAM);
     }
     wake_word_encode_task_ = xTaskCreateStatic([](void* arg) {
         auto this_ = (AfeWakeWord*)arg;
@@ -160,7 +220,15 @@ void AfeWakeWord::EncodeWakeWordData() {
             encoder->SetComplexity(0); // 0 is the fastest
 
             int packets = 0;
-            for (auto& pcm: this_->wake_word_pcm_) {
+            uint64_t cursor = this_->wake_word_pcm_->Snapshot();
+            const size_t frame_size = 16000 * OPUS_FRAME_DURATION_MS / 1000;
+            while (true) {
+                std::vector<int16_t> pcm(frame_size);
+                size_t samples = this_->wake_word_pcm_->Read(cursor, pcm.data(), pcm.size());
+                if (samples == 0) {
+                    break;
+                }
+                pcm.resize(samples);
                 encoder->Encode(std::move(pcm), [this_](std::vector<uint8_t>&& opus) {
                     std::lock_guard<std::mutex> lock(this_->wake_word_mutex_);
                     this_->wake_word_opus_.emplace_back(std::move(opus));
@@ -168,7 +236,7 @@ void AfeWakeWord::EncodeWakeWordData() {
                 });
                 packets++;
             }
-            this_->wake_word_pcm_.clear();
+            this_->wake_word_pcm_->Clear();
 
             auto end_time = esp_timer_get_time();
             ESP_LOGI(TAG, "Encode wake word opus %d packets in %ld ms", packets, (long)((end_time - start_time) / 1000));
@@ -178,8 +246,58 @@ void AfeWakeWord::EncodeWakeWordData() {
             this_->wake_word_cv_.notify_all();
         }
         vTaskDelete(NULL);
-    }, "encode_detect_packets", 4096 * 8, this, 2, wake_word_encode_task_stack_, &wake_word_encode_task_buffer_);
+    }, "encode_detect_packets", ENCODE_TASK_STACK_SIZE, this, 2, wake_word_encode_task_stack_, &wake_word_encode_task_buffer_);
+#endif
+}
+
+#if CONFIG_AFE_WAKE_WORD_CONTINUOUS_ENCODE
+void AfeWakeWord::ContinuousEncodeTask() {
+    auto encoder = std::make_unique<OpusEncoderWrapper>(16000, 1, OPUS_FRAME_DURATION_MS);
+    encoder->SetComplexity(0); // 0 is the fastest
+
+    const size_t frame_size = 16000 * OPUS_FRAME_DURATION_MS / 1000;
+    std::vector<int16_t> pcm;
+    uint64_t cursor = wake_word_pcm_->Snapshot();
+    while (true) {
+        uint32_t bits = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &bits, portMAX_DELAY);
+
+        while (wake_word_pcm_->write_position() >= cursor + frame_size) {
+            pcm.resize(frame_size);
+            if (wake_word_pcm_->Read(cursor, pcm.data(), frame_size) < frame_size) {
+                break;
+            }
+            encoder->Encode(std::move(pcm), [this](std::vector<uint8_t>&& opus) {
+                // 槽位的容量会被复用，稳定后不再分配内存
+                auto& slot = preroll_opus_[preroll_opus_head_];
+                slot.assign(opus.begin(), opus.end());
+                preroll_opus_head_ = (preroll_opus_head_ + 1) % preroll_opus_.size();
+                preroll_opus_count_ = std::min(preroll_opus_count_ + 1, preroll_opus_.size());
+            });
+        }
+
+        if (bits & ENCODE_FLUSH_EVENT) {
+            auto start_time = esp_timer_get_time();
+            PublishPrerollOpus();
+            // 下一次检测的音频与这一次不连续，重新开始编码
+            encoder->ResetState();
+            cursor = wake_word_pcm_->write_position();
+            ESP_LOGI(TAG, "Published wake word opus in %ld us", (long)(esp_timer_get_time() - start_time));
+        }
+    }
+}
+
+void AfeWakeWord::PublishPrerollOpus() {
+    std::lock_guard<std::mutex> lock(wake_word_mutex_);
+    size_t first = (preroll_opus_head_ + preroll_opus_.size() - preroll_opus_count_) % preroll_opus_.size();
+    for (size_t i = 0; i < preroll_opus_count_; i++) {
+        wake_word_opus_.push_back(preroll_opus_[(first + i) % preroll_opus_.size()]);
+    }
+    preroll_opus_count_ = 0;
+    wake_word_opus_.push_back(std::vector<uint8_t>());
+    wake_word_cv_.notify_all();
 }
+#endif
 
 bool AfeWakeWord::GetWakeWordOpus(std::vector<uint8_t>& opus) {
     std::unique_lock<std::mutex> lock(wake_word_mutex_);
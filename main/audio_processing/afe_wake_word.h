@@ -9,6 +9,7 @@
 #include <esp_nsn_models.h>
 
 #include <list>
+#include <memory>
 #include <string>
 #include <vector>
 #include <functional>
@@ -17,6 +18,7 @@
 
 #include "audio_codec.h"
 #include "wake_word.h"
+#include "pcm_ring_buffer.h"
 
 class AfeWakeWord : public WakeWord {
 public:
@@ -47,13 +49,24 @@ private:
     TaskHandle_t wake_word_encode_task_ = nullptr;
     StaticTask_t wake_word_encode_task_buffer_;
     StackType_t* wake_word_encode_task_stack_ = nullptr;
-    std::list<std::vector<int16_t>> wake_word_pcm_;
+    // 唤醒词前的音频，检测到唤醒词后编码上传用于声纹等识别
+    std::unique_ptr<PcmRingBuffer> wake_word_pcm_;
     std::list<std::vector<uint8_t>> wake_word_opus_;
     std::mutex wake_word_mutex_;
     std::condition_variable wake_word_cv_;
+#if CONFIG_AFE_WAKE_WORD_CONTINUOUS_ENCODE
+    // 持续编码的预录音频 Opus 包，固定数量的槽位循环复用
+    std::vector<std::vector<uint8_t>> preroll_opus_;
+    size_t preroll_opus_head_ = 0;
+    size_t preroll_opus_count_ = 0;
+
+    void ContinuousEncodeTask();
+    void PublishPrerollOpus();
+#endif
 
     void StoreWakeWordData(const int16_t* data, size_t size);
     void AudioDetectionTask();
+    void HandleFetchResult(afe_fetch_result_t* res);
 };
 
 #endif
@@ -1,5 +1,6 @@
 #include "esp_wake_word.h"
 #include "application.h"
+#include "sr_models.h"
 
 #include <esp_log.h>
 #include <model_path.h>
@@ -17,7 +18,6 @@ EspWakeWord::EspWakeWord() {
 EspWakeWord::~EspWakeWord() {
     if (wakenet_data_ != nullptr) {
         wakenet_iface_->destroy(wakenet_data_);
-        esp_srmodel_deinit(wakenet_model_);
     }
 
     vEventGroupDelete(event_group_);
@@ -26,8 +26,9 @@ EspWakeWord::~EspWakeWord() {
 void EspWakeWord::Initialize(AudioCodec* codec) {
     codec_ = codec;
 
-    wakenet_model_ = esp_srmodel_init("model");
-    if (wakenet_model_ == nullptr || wakenet_model_->num == -1) {
+    // 模型列表由 SrModels 持有，这里不再单独释放
+    wakenet_model_ = SrModels::GetInstance().Get();
+    if (wakenet_model_ == nullptr) {
         ESP_LOGE(TAG, "Failed to initialize wakenet model");
         return;
     }
@@ -0,0 +1,80 @@
+#include "pcm_ring_buffer.h"
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+
+#include <algorithm>
+#include <cstring>
+
+#define TAG "PcmRingBuffer"
+
+PcmRingBuffer::PcmRingBuffer(size_t capacity) : capacity_(capacity) {
+    buffer_ = (int16_t*)heap_caps_malloc(capacity_ * sizeof(int16_t), MALLOC_CAP_SPIRAM);
+    if (buffer_ == nullptr) {
+        buffer_ = (int16_t*)heap_caps_malloc(capacity_ * sizeof(int16_t), MALLOC_CAP_8BIT);
+    }
+    if (buffer_ == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate %u samples", capacity_);
+        capacity_ = 0;
+    }
+}
+
+PcmRingBuffer::~PcmRingBuffer() {
+    if (buffer_ != nullptr) {
+        heap_caps_free(buffer_);
+    }
+}
+
+void PcmRingBuffer::Write(const int16_t* data, size_t samples) {
+    if (capacity_ == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 超过容量的部分只保留最后 capacity_ 个采样
+    if (samples > capacity_) {
+        write_position_ += samples - capacity_;
+        data += samples - capacity_;
+        samples = capacity_;
+    }
+    size_t offset = write_position_ % capacity_;
+    size_t first = std::min(samples, capacity_ - offset);
+    memcpy(buffer_ + offset, data, first * sizeof(int16_t));
+    memcpy(buffer_, data + first, (samples - first) * sizeof(int16_t));
+    write_position_ += samples;
+}
+
+void PcmRingBuffer::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    start_position_ = write_position_;
+}
+
+uint64_t PcmRingBuffer::Snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::max(start_position_, write_position_ > capacity_ ? write_position_ - capacity_ : 0);
+}
+
+uint64_t PcmRingBuffer::write_position() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return write_position_;
+}
+
+size_t PcmRingBuffer::Read(uint64_t& cursor, int16_t* out, size_t samples) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t oldest = std::max(start_position_, write_position_ > capacity_ ? write_position_ - capacity_ : 0);
+    if (cursor < oldest) {
+        cursor = oldest;
+    }
+    if (cursor >= write_position_) {
+        return 0;
+    }
+    samples = std::min<uint64_t>(samples, write_position_ - cursor);
+    if (samples == 0) {
+        return 0;
+    }
+    size_t offset = cursor % capacity_;
+    size_t first = std::min(samples, capacity_ - offset);
+    memcpy(out, buffer_ + offset, first * sizeof(int16_t));
+    memcpy(out + first, buffer_, (samples - first) * sizeof(int16_t));
+    cursor += samples;
+    return samples;
+}
@@ -0,0 +1,35 @@
+#ifndef PCM_RING_BUFFER_H
+#define PCM_RING_BUFFER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+
+// 固定容量的 PCM 环形缓冲区，内存在构造时一次性分配（优先 PSRAM），写入时不再分配内存。
+// 读取使用游标：游标是从开始写入起的绝对采样位置，读取者落后太多时跳到最早仍保存的数据。
+class PcmRingBuffer {
+public:
+    PcmRingBuffer(size_t capacity);
+    ~PcmRingBuffer();
+
+    void Write(const int16_t* data, size_t samples);
+    // 清空数据，已有游标会在下一次读取时跳到新的数据
+    void Clear();
+
+    // 当前保存的最早一个采样的位置，用作新游标的起点
+    uint64_t Snapshot() const;
+    uint64_t write_position() const;
+    // 从 cursor 处最多读取 samples 个采样并移动游标，返回实际读取的数量
+    size_t Read(uint64_t& cursor, int16_t* out, size_t samples) const;
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    int16_t* buffer_ = nullptr;
+    size_t capacity_ = 0;
+    uint64_t write_position_ = 0;
+    uint64_t start_position_ = 0;
+    mutable std::mutex mutex_;
+};
+
+#endif // PCM_RING_BUFFER_H
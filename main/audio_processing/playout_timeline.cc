@@ -0,0 +1,109 @@
+#include "playout_timeline.h"
+
+// 输出 DMA 与解码队列中最多容纳的下行帧数远小于该值，超出时丢弃最早的记录
+#define MAX_PLAYOUT_MARKS 32
+// 音频处理器停止后不再取出采集记录，只保留最近的若干块
+#define MAX_CAPTURE_MARKS 64
+
+PlayoutTimeline::PlayoutTimeline(int capture_sample_rate) : capture_sample_rate_(capture_sample_rate) {
+}
+
+void PlayoutTimeline::OnPlayout(uint32_t end_position, uint32_t frames, int sample_rate, uint32_t timestamp) {
+    if (frames == 0 || sample_rate <= 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    playout_marks_.push_back({end_position, frames, sample_rate, timestamp});
+    if (playout_marks_.size() > MAX_PLAYOUT_MARKS) {
+        playout_marks_.pop_front();
+    }
+}
+
+void PlayoutTimeline::Truncate(uint32_t end_position) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (playout_marks_.empty()) {
+        return;
+    }
+    auto& mark = playout_marks_.back();
+    int32_t cut = (int32_t)(mark.end_position - end_position);
+    if (cut <= 0) {
+        return;
+    }
+    if ((uint32_t)cut >= mark.frames) {
+        playout_marks_.pop_back();
+        return;
+    }
+    mark.end_position = end_position;
+    mark.frames -= cut;
+}
+
+uint32_t PlayoutTimeline::TimestampAt(uint32_t position) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 位置是回绕的计数，用差值的符号比较先后
+    while (!playout_marks_.empty() && (int32_t)(position - playout_marks_.front().end_position) >= 0) {
+        playout_marks_.pop_front();
+    }
+    for (auto& mark : playout_marks_) {
+        uint32_t offset = position - (mark.end_position - mark.frames);
+        if (offset < mark.frames) {
+            if (mark.timestamp == 0) {
+                return 0;
+            }
+            return mark.timestamp + (uint64_t)offset * 1000 / mark.sample_rate;
+        }
+    }
+    return 0;
+}
+
+void PlayoutTimeline::OnCapture(uint32_t samples, uint32_t playout_timestamp, int64_t capture_time, uint32_t output_delay_ms) {
+    if (samples == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    capture_marks_.push_back({samples, playout_timestamp, capture_time, output_delay_ms});
+    if (capture_marks_.size() > MAX_CAPTURE_MARKS) {
+        capture_marks_.pop_front();
+        capture_offset_ = 0;
+    }
+}
+
+PlayoutTimeline::UplinkTag PlayoutTimeline::TakeUplink(uint32_t samples, int64_t now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    UplinkTag tag;
+    if (!capture_marks_.empty()) {
+        auto& mark = capture_marks_.front();
+        int64_t capture_time = mark.capture_time + (int64_t)capture_offset_ * 1000000 / capture_sample_rate_;
+        if (mark.playout_timestamp != 0) {
+            tag.timestamp = mark.playout_timestamp + (uint64_t)capture_offset_ * 1000 / capture_sample_rate_;
+        }
+        if (now > capture_time) {
+            tag.loopback_delay_ms = mark.output_delay_ms + (now - capture_time) / 1000;
+        }
+    }
+
+    // 按采样数消耗采集记录，一个上行帧可能跨越多块
+    while (samples > 0 && !capture_marks_.empty()) {
+        uint32_t left = capture_marks_.front().samples - capture_offset_;
+        if (samples < left) {
+            capture_offset_ += samples;
+            break;
+        }
+        samples -= left;
+        capture_marks_.pop_front();
+        capture_offset_ = 0;
+    }
+    return tag;
+}
+
+void PlayoutTimeline::ResetCapture() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capture_marks_.clear();
+    capture_offset_ = 0;
+}
+
+void PlayoutTimeline::Reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    playout_marks_.clear();
+    capture_marks_.clear();
+    capture_offset_ = 0;
+}
@@ -0,0 +1,61 @@
+#ifndef PLAYOUT_TIMELINE_H
+#define PLAYOUT_TIMELINE_H
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+// 服务端 AEC 的时间对齐：记录每个下行帧在输出流中的位置，按扬声器实际播放到的位置
+// 查出当时正在播放的服务器时间戳，再按采样顺序标记到同一时刻采集的上行帧上。
+// 只依赖标准库，可以在 PC 上测试。
+class PlayoutTimeline {
+public:
+    struct UplinkTag {
+        // 采集上行帧第一个采样时正在播放的服务器时间戳（毫秒），没有在播放时为 0
+        uint32_t timestamp = 0;
+        // 设备端回环延迟（毫秒）：下行音频从写入输出到播放的缓冲延迟，加上采集到打标记的延迟
+        uint32_t loopback_delay_ms = 0;
+    };
+
+    explicit PlayoutTimeline(int capture_sample_rate);
+
+    // 一个下行帧写入输出之前调用。end_position: 整帧写入后输出流的累计帧数
+    void OnPlayout(uint32_t end_position, uint32_t frames, int sample_rate, uint32_t timestamp);
+    // 最后一个下行帧只写入到 end_position 为止时调用，截短它的记录
+    void Truncate(uint32_t end_position);
+    // 输出流位置 position 处正在播放的服务器时间戳，不在任何下行帧内时返回 0
+    uint32_t TimestampAt(uint32_t position);
+
+    // 采集一块送往音频处理器的音频后调用，samples 为每声道采样数，
+    // capture_time 为第一个采样的采集时间（微秒），output_delay_ms 为当时的输出缓冲延迟
+    void OnCapture(uint32_t samples, uint32_t playout_timestamp, int64_t capture_time, uint32_t output_delay_ms);
+    // 音频处理器按采集顺序输出 samples 个采样时调用，返回其第一个采样的标记，now 为当前时间（微秒）
+    UplinkTag TakeUplink(uint32_t samples, int64_t now);
+
+    // 音频处理器重新开始时调用，丢弃未输出的采集记录
+    void ResetCapture();
+    void Reset();
+
+private:
+    struct PlayoutMark {
+        uint32_t end_position;
+        uint32_t frames;
+        int sample_rate;
+        uint32_t timestamp;
+    };
+    struct CaptureMark {
+        uint32_t samples;
+        uint32_t playout_timestamp;
+        int64_t capture_time;
+        uint32_t output_delay_ms;
+    };
+
+    int capture_sample_rate_;
+    std::mutex mutex_;
+    std::deque<PlayoutMark> playout_marks_;
+    std::deque<CaptureMark> capture_marks_;
+    // 最早一个采集记录中已经输出的采样数
+    uint32_t capture_offset_ = 0;
+};
+
+#endif // PLAYOUT_TIMELINE_H
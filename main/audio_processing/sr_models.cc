@@ -0,0 +1,30 @@
+#include "sr_models.h"
+
+#include <esp_log.h>
+
+#define TAG "SrModels"
+
+srmodel_list_t* SrModels::Get() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!loaded_) {
+        loaded_ = true;
+        models_ = esp_srmodel_init("model");
+        if (models_ == nullptr || models_->num == -1) {
+            ESP_LOGE(TAG, "Failed to load models from the model partition");
+            models_ = nullptr;
+        } else {
+            for (int i = 0; i < models_->num; i++) {
+                ESP_LOGI(TAG, "Model %d: %s", i, models_->model_name[i]);
+            }
+        }
+    }
+    return models_;
+}
+
+char* SrModels::Filter(const char* prefix, const char* keyword) {
+    auto models = Get();
+    if (models == nullptr) {
+        return nullptr;
+    }
+    return esp_srmodel_filter(models, prefix, keyword);
+}
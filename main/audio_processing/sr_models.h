@@ -0,0 +1,33 @@
+#ifndef SR_MODELS_H
+#define SR_MODELS_H
+
+#include <model_path.h>
+
+#include <mutex>
+
+// 模型分区只解析一次，唤醒词与音频处理共用同一份模型列表
+class SrModels {
+public:
+    static SrModels& GetInstance() {
+        static SrModels instance;
+        return instance;
+    }
+    // Delete copy constructor and assignment operator
+    SrModels(const SrModels&) = delete;
+    SrModels& operator=(const SrModels&) = delete;
+
+    // 加载失败时返回 nullptr
+    srmodel_list_t* Get();
+    // 按前缀查找模型名称，如 ESP_WN_PREFIX、ESP_NSNET_PREFIX
+    char* Filter(const char* prefix, const char* keyword = nullptr);
+
+private:
+    SrModels() = default;
+    ~SrModels() = default;
+
+    std::mutex mutex_;
+    bool loaded_ = false;
+    srmodel_list_t* models_ = nullptr;
+};
+
+#endif // SR_MODELS_H
@@ -0,0 +1,119 @@
+#include "wake_word_gate.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+// 噪声底上升慢（约 1/64）、下降快（约 1/4），说话时不会被迅速抬高
+#define NOISE_RISE_SHIFT 6
+#define NOISE_FALL_SHIFT 2
+// 看起来像语音时噪声底仍按该时间常数（采样数，16kHz 下约 30 秒）缓慢上升，
+// 突然出现的稳态噪声（风扇、电视）几秒到十几秒后就不再让门限一直打开
+#define NOISE_OPEN_RISE_FRAMES (16000 * 30)
+
+WakeWordGate::WakeWordGate(int channels, int lookback_samples)
+    : channels_(std::max(channels, 1)), lookback_samples_(std::max(lookback_samples, 0)) {
+}
+
+void WakeWordGate::SetThreshold(int ratio_percent, int min_level) {
+    ratio_percent_ = std::max(ratio_percent, 100);
+    min_level_ = std::max(min_level, 0);
+}
+
+void WakeWordGate::SetHangover(int samples) {
+    hangover_samples_ = std::max(samples, 0);
+}
+
+void WakeWordGate::Reset() {
+    reset_pending_ = true;
+}
+
+bool WakeWordGate::Feed(std::vector<int16_t>& data, const std::function<void(const std::vector<int16_t>& data)>& output) {
+    if (reset_pending_.exchange(false)) {
+        open_ = false;
+        hangover_left_ = 0;
+        lookback_head_ = 0;
+        lookback_count_ = 0;
+    }
+
+    total_chunks_++;
+    int frames = data.size() / channels_;
+
+    if (IsSpeechLike(data)) {
+        hangover_left_ = hangover_samples_;
+        if (!open_) {
+            open_ = true;
+            // 先补发回看音频，保证唤醒词的开头完整
+            size_t first = (lookback_head_ + lookback_.size() - lookback_count_) % std::max<size_t>(lookback_.size(), 1);
+            for (size_t i = 0; i < lookback_count_; i++) {
+                output(lookback_[(first + i) % lookback_.size()]);
+            }
+            lookback_count_ = 0;
+        }
+    } else if (open_) {
+        hangover_left_ -= frames;
+        if (hangover_left_ <= 0) {
+            open_ = false;
+        }
+    }
+
+    if (open_) {
+        passed_chunks_++;
+        output(data);
+        return true;
+    }
+    PushLookback(data);
+    return false;
+}
+
+bool WakeWordGate::IsSpeechLike(const std::vector<int16_t>& data) {
+    int frames = data.size() / channels_;
+    if (frames == 0) {
+        return false;
+    }
+
+    int64_t sum = 0;
+    int crossings = 0;
+    int16_t previous = data[0];
+    for (int i = 0; i < frames; i++) {
+        int16_t sample = data[i * channels_];
+        sum += abs(sample);
+        if ((sample ^ previous) < 0) {
+            crossings++;
+        }
+        previous = sample;
+    }
+    level_ = sum / frames;
+    int zcr_permille = crossings * 1000 / frames;
+
+    if (noise_floor_ < 0) {
+        noise_floor_ = level_ << 4;
+    }
+    int floor = noise_floor_ >> 4;
+    bool loud = level_ >= min_level_ && level_ * 100 >= floor * ratio_percent_;
+    bool speech_like = loud && zcr_permille <= max_zcr_permille_;
+
+    // 安静时正常更新噪声底；像语音时只按时间缓慢上升，持续的稳态噪声（如风扇）最终会被当作背景
+    int diff = (level_ << 4) - noise_floor_;
+    if (!speech_like || diff < 0) {
+        noise_floor_ += diff >> (diff > 0 ? NOISE_RISE_SHIFT : NOISE_FALL_SHIFT);
+    } else {
+        noise_floor_ += std::max<int64_t>((int64_t)diff * frames / NOISE_OPEN_RISE_FRAMES, 1);
+    }
+    return speech_like;
+}
+
+void WakeWordGate::PushLookback(std::vector<int16_t>& data) {
+    int frames = data.size() / channels_;
+    if (frames == 0 || lookback_samples_ == 0) {
+        return;
+    }
+    if (lookback_.empty()) {
+        // 第一次输入时按块大小确定槽位数量
+        lookback_.resize((lookback_samples_ + frames - 1) / frames);
+    }
+    // 交换而不是复制，调用者的缓冲区换成一个旧槽位
+    lookback_[lookback_head_].swap(data);
+    lookback_head_ = (lookback_head_ + 1) % lookback_.size();
+    lookback_count_ = std::min(lookback_count_ + 1, lookback_.size());
+}
+
@@ -0,0 +1,63 @@
+#ifndef WAKE_WORD_GATE_H
+#define WAKE_WORD_GATE_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// 唤醒词前的低功耗门限：用定点的短时能量与过零率判断是否可能有人说话，
+// 安静时不把音频送入唤醒词模型。关闭期间保留最近一段音频，打开时先补发，避免丢失开头。
+// 只依赖标准库，可以在 PC 上用录音测试与调参（tests/host/wake_word_gate_test）。
+class WakeWordGate {
+public:
+    // channels: 交错排列的声道数，只分析第 0 声道（麦克风）
+    // lookback_samples: 每声道保留的采样数
+    WakeWordGate(int channels, int lookback_samples);
+
+    // ratio_percent: 能量高于噪声底的倍数（百分比）才打开
+    // min_level: 平均幅度的最小值，低于该值始终视为安静
+    void SetThreshold(int ratio_percent, int min_level);
+    // 打开后至少保持的采样数，避免在字与字之间的停顿处关闭
+    void SetHangover(int samples);
+
+    // 输入一块音频，门限打开时通过 output 输出（包括补发的回看音频），返回本块是否通过
+    bool Feed(std::vector<int16_t>& data, const std::function<void(const std::vector<int16_t>& data)>& output);
+    // 关闭门限并丢弃回看音频，保留噪声底。可以在其他线程调用，下一次 Feed 时生效
+    void Reset();
+
+    bool is_open() const { return open_; }
+    // 最近一块的平均幅度与噪声底，用于调参
+    int level() const { return level_; }
+    int noise_floor() const { return noise_floor_ >> 4; }
+    uint32_t total_chunks() const { return total_chunks_; }
+    uint32_t passed_chunks() const { return passed_chunks_; }
+
+private:
+    int channels_;
+    int lookback_samples_;
+    int ratio_percent_ = 300;
+    int min_level_ = 150;
+    int hangover_samples_ = 16000;
+    // 过零率高于该比例（千分比）视为嘶声或电流声，而不是语音
+    int max_zcr_permille_ = 400;
+
+    std::atomic<bool> reset_pending_ = false;
+    bool open_ = false;
+    int hangover_left_ = 0;
+    int level_ = 0;
+    // 噪声底为平均幅度的滑动估计，4 位小数的定点数
+    int noise_floor_ = -1;
+    uint32_t total_chunks_ = 0;
+    uint32_t passed_chunks_ = 0;
+
+    // 回看音频按块保存，槽位循环复用，稳定后不再分配内存
+    std::vector<std::vector<int16_t>> lookback_;
+    size_t lookback_head_ = 0;
+    size_t lookback_count_ = 0;
+
+    bool IsSpeechLike(const std::vector<int16_t>& data);
+    void PushLookback(std::vector<int16_t>& data);
+};
+
+#endif // WAKE_WORD_GATE_H
@@ -2,6 +2,8 @@
 #define CAMERA_H
 
 #include <string>
+#include <vector>
+#include <cstdint>
 
 class Camera {
 public:
@@ -10,6 +12,11 @@ public:
     virtual bool SetHMirror(bool enabled) = 0;
     virtual bool SetVFlip(bool enabled) = 0;
     virtual std::string Explain(const std::string& question) = 0;
+
+    // 连续视觉模式：抓取新的一帧并输出低分辨率亮度图（luma_width * luma_height 字节），
+    // 然后按需把同一帧编码为 JPEG。不支持的摄像头返回 false
+    virtual bool CaptureStreamFrame(uint8_t* luma, int luma_width, int luma_height) { return false; }
+    virtual bool EncodeStreamFrame(std::vector<uint8_t>& jpeg, int max_width, int quality) { return false; }
 };
 
 #endif // CAMERA_H
@@ -6,11 +6,19 @@
 
 #include <esp_log.h>
 #include <esp_heap_caps.h>
+#include <esp_timer.h>
 #include <img_converters.h>
 #include <cstring>
+#include <algorithm>
 
 #define TAG "Esp32Camera"
 
+#define UPLOAD_CHUNK_SIZE 4096
+#define UPLOAD_CHUNK_COUNT 8
+#define JPEG_CACHE_INITIAL_SIZE (64 * 1024)
+// 只有一个帧缓冲时，照片占用期间连续视觉模式暂停采集，超过该时间仍未识图则释放照片
+#define PHOTO_HOLD_TIMEOUT_MS 30000
+
 Esp32Camera::Esp32Camera(const camera_config_t& config) {
     // camera init
     esp_err_t err = esp_camera_init(&config); // 配置上面定义的参数
@@ -18,64 +26,83 @@ Esp32Camera::Esp32Camera(const camera_config_t& config) {
         ESP_LOGE(TAG, "Camera init failed with error 0x%x", err);
         return;
     }
+    fb_count_ = config.fb_count;
 
     sensor_t *s = esp_camera_sensor_get(); // 获取摄像头型号
     if (s->id.PID == GC0308_PID) {
         s->set_hmirror(s, 0);  // 这里控制摄像头镜像 写1镜像 写0不镜像
     }
 
-    // 初始化预览图片的内存
-    memset(&preview_image_, 0, sizeof(preview_image_));
-    preview_image_.header.magic = LV_IMAGE_HEADER_MAGIC;
-    preview_image_.header.cf = LV_COLOR_FORMAT_RGB565;
-    preview_image_.header.flags = LV_IMAGE_FLAGS_ALLOCATED | LV_IMAGE_FLAGS_MODIFIABLE;
+    // 上传缓冲区环，编码线程填满一块就交给上传，上传完再还回来
+    upload_buffers_ = (uint8_t*)heap_caps_malloc(UPLOAD_CHUNK_SIZE * UPLOAD_CHUNK_COUNT, MALLOC_CAP_SPIRAM);
+    free_chunks_ = xQueueCreate(UPLOAD_CHUNK_COUNT, sizeof(JpegChunk));
+    filled_chunks_ = xQueueCreate(UPLOAD_CHUNK_COUNT + 1, sizeof(JpegChunk));
+    if (upload_buffers_ == nullptr || free_chunks_ == nullptr || filled_chunks_ == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate upload buffers");
+    } else {
+        for (int i = 0; i < UPLOAD_CHUNK_COUNT; i++) {
+            JpegChunk chunk = {
+                .data = upload_buffers_ + i * UPLOAD_CHUNK_SIZE,
+                .len = 0
+            };
+            xQueueSend(free_chunks_, &chunk, 0);
+        }
+    }
 
+    // 预览图片按需分配，显示端引用同一块内存，不再拷贝
+    int width, height;
     switch (config.frame_size) {
         case FRAMESIZE_SVGA:
-            preview_image_.header.w = 800;
-            preview_image_.header.h = 600;
+            width = 800;
+            height = 600;
             break;
         case FRAMESIZE_VGA:
-            preview_image_.header.w = 640;
-            preview_image_.header.h = 480;
+            width = 640;
+            height = 480;
             break;
         case FRAMESIZE_QVGA:
-            preview_image_.header.w = 320;
-            preview_image_.header.h = 240;
+            width = 320;
+            height = 240;
             break;
         case FRAMESIZE_128X128:
-            preview_image_.header.w = 128;
-            preview_image_.header.h = 128;
+            width = 128;
+            height = 128;
             break;
         case FRAMESIZE_240X240:
-            preview_image_.header.w = 240;
-            preview_image_.header.h = 240;
+            width = 240;
+            height = 240;
             break;
         default:
             ESP_LOGE(TAG, "Unsupported frame size: %d, image preview will not be shown", config.frame_size);
-            preview_image_.data_size = 0;
-            preview_image_.data = nullptr;
             return;
     }
-
-    preview_image_.header.stride = preview_image_.header.w * 2;
-    preview_image_.data_size = preview_image_.header.w * preview_image_.header.h * 2;
-    preview_image_.data = (uint8_t*)heap_caps_malloc(preview_image_.data_size, MALLOC_CAP_SPIRAM);
-    if (preview_image_.data == nullptr) {
-        ESP_LOGE(TAG, "Failed to allocate memory for preview image");
-        return;
-    }
+    preview_pool_ = std::make_unique<PreviewImagePool>(width, height);
 }
 
 Esp32Camera::~Esp32Camera() {
+    if (encoder_thread_.joinable()) {
+        encoder_thread_.join();
+    }
+    if (jpeg_cache_) {
+        heap_caps_free(jpeg_cache_);
+        jpeg_cache_ = nullptr;
+    }
+    if (free_chunks_) {
+        vQueueDelete(free_chunks_);
+    }
+    if (filled_chunks_) {
+        vQueueDelete(filled_chunks_);
+    }
+    if (upload_buffers_) {
+        heap_caps_free(upload_buffers_);
+        upload_buffers_ = nullptr;
+    }
     if (fb_) {
         esp_camera_fb_return(fb_);
         fb_ = nullptr;
     }
-    if (preview_image_.data) {
-        heap_caps_free((void*)preview_image_.data);
-        preview_image_.data = nullptr;
-    }
+    ReturnStreamFrame();
+    preview_pool_.reset();
     esp_camera_deinit();
 }
 
@@ -84,11 +111,40 @@ void Esp32Camera::SetExplainUrl(const std::string& url, const std::string& token
     explain_token_ = token;
 }
 
+// 交换 RGB565 每个像素的高低字节，一次处理两个像素，并展开循环减少 PSRAM 访问的停顿
+static void SwapRgb565Bytes(const uint8_t* src, uint8_t* dst, size_t len) {
+    auto s = (const uint32_t*)src;
+    auto d = (uint32_t*)dst;
+    size_t words = len / 4;
+    size_t i = 0;
+    for (; i + 4 <= words; i += 4) {
+        uint32_t v0 = s[i], v1 = s[i + 1], v2 = s[i + 2], v3 = s[i + 3];
+        d[i] = ((v0 & 0x00FF00FF) << 8) | ((v0 >> 8) & 0x00FF00FF);
+        d[i + 1] = ((v1 & 0x00FF00FF) << 8) | ((v1 >> 8) & 0x00FF00FF);
+        d[i + 2] = ((v2 & 0x00FF00FF) << 8) | ((v2 >> 8) & 0x00FF00FF);
+        d[i + 3] = ((v3 & 0x00FF00FF) << 8) | ((v3 >> 8) & 0x00FF00FF);
+    }
+    for (; i < words; i++) {
+        uint32_t v = s[i];
+        d[i] = ((v & 0x00FF00FF) << 8) | ((v >> 8) & 0x00FF00FF);
+    }
+    if (len & 2) {
+        ((uint16_t*)dst)[len / 2 - 1] = __builtin_bswap16(((const uint16_t*)src)[len / 2 - 1]);
+    }
+}
+
 bool Esp32Camera::Capture() {
+    std::lock_guard<std::mutex> lock(mutex_);
     if (encoder_thread_.joinable()) {
         encoder_thread_.join();
     }
 
+    // 新照片需要重新编码
+    jpeg_cache_valid_ = false;
+    // 连续视觉模式的帧可以随时丢弃，先还给驱动，保证只有一个帧缓冲时也能拍照
+    ReturnStreamFrame();
+
+    int64_t start_time = esp_timer_get_time();
     int frames_to_get = 2;
     // Try to get a stable frame
     for (int i = 0; i < frames_to_get; i++) {
@@ -101,31 +157,34 @@ bool Esp32Camera::Capture() {
             return false;
         }
     }
+    capture_time_ = start_time;
 
-    // 如果预览图片 buffer 为空，则跳过预览
+    // 如果预览图片不可用，则跳过预览
     // 但仍返回 true，因为此时图像可以上传至服务器
-    if (preview_image_.data_size == 0) {
+    if (preview_pool_ == nullptr) {
         ESP_LOGW(TAG, "Skip preview because of unsupported frame size");
         return true;
     }
-    if (preview_image_.data == nullptr) {
-        ESP_LOGE(TAG, "Preview image data is not initialized");
-        return true;
-    }
     // 显示预览图片
     auto display = Board::GetInstance().GetDisplay();
     if (display != nullptr) {
-        auto src = (uint16_t*)fb_->buf;
-        auto dst = (uint16_t*)preview_image_.data;
-        size_t pixel_count = fb_->len / 2;
-        for (size_t i = 0; i < pixel_count; i++) {
-            // 交换每个16位字内的字节
-            dst[i] = __builtin_bswap16(src[i]);
+        auto image = preview_pool_->Acquire();
+        if (image == nullptr) {
+            ESP_LOGE(TAG, "No preview image available");
+            return true;
         }
-        display->SetPreviewImage(&preview_image_);
+        int64_t swap_start_time = esp_timer_get_time();
+        SwapRgb565Bytes(fb_->buf, image->data(), std::min(fb_->len, image->size()));
+        int64_t swap_end_time = esp_timer_get_time();
+        image->set_capture_time(start_time);
+        display->SetPreviewImage(image);
+        ESP_LOGI(TAG, "Preview %dx%d: capture %lld ms, byte swap %lld ms, display %lld ms",
+            image->width(), image->height(), (swap_start_time - start_time) / 1000,
+            (swap_end_time - swap_start_time) / 1000, (esp_timer_get_time() - swap_end_time) / 1000);
     }
     return true;
 }
+
 bool Esp32Camera::SetHMirror(bool enabled) {
     sensor_t *s = esp_camera_sensor_get();
     if (s == nullptr) {
@@ -160,6 +219,133 @@ bool Esp32Camera::SetVFlip(bool enabled) {
     return true;
 }
 
+// 按 factor 缩小 RGB565 图像（大端字节序），每个输出像素取块内 2x2 个采样点的平均值
+static void DownscaleRgb565(const uint8_t* src, int src_width, uint8_t* dst, int dst_width, int dst_height, int factor) {
+    auto s = (const uint16_t*)src;
+    auto d = (uint16_t*)dst;
+    int half = factor / 2;
+    for (int y = 0; y < dst_height; y++) {
+        const uint16_t* row0 = s + y * factor * src_width;
+        const uint16_t* row1 = row0 + half * src_width;
+        for (int x = 0; x < dst_width; x++) {
+            int sx = x * factor;
+            uint16_t p0 = __builtin_bswap16(row0[sx]);
+            uint16_t p1 = __builtin_bswap16(row0[sx + half]);
+            uint16_t p2 = __builtin_bswap16(row1[sx]);
+            uint16_t p3 = __builtin_bswap16(row1[sx + half]);
+            uint32_t r = (p0 >> 11) + (p1 >> 11) + (p2 >> 11) + (p3 >> 11);
+            uint32_t g = ((p0 >> 5) & 0x3F) + ((p1 >> 5) & 0x3F) + ((p2 >> 5) & 0x3F) + ((p3 >> 5) & 0x3F);
+            uint32_t b = (p0 & 0x1F) + (p1 & 0x1F) + (p2 & 0x1F) + (p3 & 0x1F);
+            *d++ = __builtin_bswap16(((r / 4) << 11) | ((g / 4) << 5) | (b / 4));
+        }
+    }
+}
+
+void Esp32Camera::OnJpegData(const uint8_t* data, size_t len) {
+    // 追加到缓存，内存不足时放弃缓存，但不影响本次上传
+    if (jpeg_cache_valid_) {
+        if (jpeg_cache_size_ + len > jpeg_cache_capacity_) {
+            size_t capacity = std::max(jpeg_cache_capacity_ * 2, jpeg_cache_size_ + len);
+            auto cache = (uint8_t*)heap_caps_realloc(jpeg_cache_, capacity, MALLOC_CAP_SPIRAM);
+            if (cache == nullptr) {
+                ESP_LOGW(TAG, "Failed to grow JPEG cache to %u bytes", capacity);
+                jpeg_cache_valid_ = false;
+            } else {
+                jpeg_cache_ = cache;
+                jpeg_cache_capacity_ = capacity;
+            }
+        }
+        if (jpeg_cache_valid_) {
+            memcpy(jpeg_cache_ + jpeg_cache_size_, data, len);
+            jpeg_cache_size_ += len;
+        }
+    }
+
+    // 拷贝到上传缓冲区，满一块就交给上传
+    while (len > 0) {
+        if (upload_chunk_.data == nullptr) {
+            xQueueReceive(free_chunks_, &upload_chunk_, portMAX_DELAY);
+            upload_chunk_.len = 0;
+        }
+        size_t n = std::min(len, (size_t)UPLOAD_CHUNK_SIZE - upload_chunk_.len);
+        memcpy(upload_chunk_.data + upload_chunk_.len, data, n);
+        upload_chunk_.len += n;
+        data += n;
+        len -= n;
+        if (upload_chunk_.len == UPLOAD_CHUNK_SIZE) {
+            xQueueSend(filled_chunks_, &upload_chunk_, portMAX_DELAY);
+            upload_chunk_.data = nullptr;
+        }
+    }
+}
+
+void Esp32Camera::EncodeJpeg() {
+    uint8_t* src = fb_->buf;
+    size_t src_len = fb_->len;
+    jpeg_width_ = fb_->width;
+    jpeg_height_ = fb_->height;
+
+    // 先缩小再编码，编码耗时与像素数成正比
+    uint8_t* scaled = nullptr;
+    int factor = 1;
+    if (fb_->format == PIXFORMAT_RGB565) {
+        while (fb_->width / factor > CONFIG_CAMERA_EXPLAIN_MAX_WIDTH) {
+            factor *= 2;
+        }
+    }
+    if (factor > 1) {
+        int width = fb_->width / factor;
+        int height = fb_->height / factor;
+        scaled = (uint8_t*)heap_caps_malloc(width * height * 2, MALLOC_CAP_SPIRAM);
+        if (scaled == nullptr) {
+            ESP_LOGW(TAG, "Failed to allocate downscale buffer, encoding the full frame");
+        } else {
+            DownscaleRgb565(fb_->buf, fb_->width, scaled, width, height, factor);
+            src = scaled;
+            src_len = width * height * 2;
+            jpeg_width_ = width;
+            jpeg_height_ = height;
+        }
+    }
+
+    if (jpeg_cache_ == nullptr) {
+        jpeg_cache_ = (uint8_t*)heap_caps_malloc(JPEG_CACHE_INITIAL_SIZE, MALLOC_CAP_SPIRAM);
+        jpeg_cache_capacity_ = jpeg_cache_ != nullptr ? JPEG_CACHE_INITIAL_SIZE : 0;
+    }
+    jpeg_cache_size_ = 0;
+    jpeg_cache_valid_ = jpeg_cache_ != nullptr;
+
+    bool success = fmt2jpg_cb(src, src_len, jpeg_width_, jpeg_height_, fb_->format, CONFIG_CAMERA_EXPLAIN_JPEG_QUALITY,
+        [](void* arg, size_t index, const void* data, size_t len) -> unsigned int {
+            if (data != nullptr && len > 0) {
+                ((Esp32Camera*)arg)->OnJpegData((const uint8_t*)data, len);
+            }
+            return len;
+        }, this);
+    if (scaled != nullptr) {
+        heap_caps_free(scaled);
+    }
+    if (!success) {
+        ESP_LOGE(TAG, "Failed to encode JPEG");
+        jpeg_cache_valid_ = false;
+    }
+
+    // 发送最后不满的一块，然后发送结束标记
+    if (upload_chunk_.data != nullptr) {
+        if (upload_chunk_.len > 0) {
+            xQueueSend(filled_chunks_, &upload_chunk_, portMAX_DELAY);
+        } else {
+            xQueueSend(free_chunks_, &upload_chunk_, portMAX_DELAY);
+        }
+        upload_chunk_.data = nullptr;
+    }
+    JpegChunk end = {
+        .data = nullptr,
+        .len = 0
+    };
+    xQueueSend(filled_chunks_, &end, portMAX_DELAY);
+}
+
 /**
  * @brief 将摄像头捕获的图像发送到远程服务器进行AI分析和解释
  * 
@@ -168,9 +354,10 @@ bool Esp32Camera::SetVFlip(bool enabled) {
  * 问题对图像进行AI分析并返回结果。
  * 
  * 实现特点：
- * - 使用独立线程编码JPEG，与主线程分离
+ * - 使用独立线程编码JPEG，与主线程分离，编码前先缩小到 CONFIG_CAMERA_EXPLAIN_MAX_WIDTH
  * - 采用分块传输编码(chunked transfer encoding)优化内存使用
- * - 通过队列机制实现编码线程和发送线程的数据同步
+ * - 通过固定的缓冲区环实现编码线程和发送线程的数据同步
+ * - 编码结果按拍照缓存，同一张照片再次提问时直接上传
  * - 支持设备ID、客户端ID和认证令牌的HTTP头部配置
  * 
  * @param question 要向AI提出的关于图像的问题，将作为表单字段发送
@@ -188,26 +375,26 @@ std::string Esp32Camera::Explain(const std::string& question) {
         return "{\"success\": false, \"message\": \"Image explain URL or token is not set\"}";
     }
 
-    // 创建局部的 JPEG 队列, 40 entries is about to store 512 * 40 = 20480 bytes of JPEG data
-    QueueHandle_t jpeg_queue = xQueueCreate(40, sizeof(JpegChunk));
-    if (jpeg_queue == nullptr) {
-        ESP_LOGE(TAG, "Failed to create JPEG queue");
-        return "{\"success\": false, \"message\": \"Failed to create JPEG queue\"}";
+    // 编码和上传期间连续视觉模式不能抓取新帧
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (fb_ == nullptr && !jpeg_cache_valid_) {
+        return "{\"success\": false, \"message\": \"No photo captured\"}";
+    }
+    if (upload_buffers_ == nullptr || free_chunks_ == nullptr || filled_chunks_ == nullptr) {
+        return "{\"success\": false, \"message\": \"Upload buffers are not initialized\"}";
+    }
+    if (encoder_thread_.joinable()) {
+        encoder_thread_.join();
     }
 
-    // We spawn a thread to encode the image to JPEG
-    encoder_thread_ = std::thread([this, jpeg_queue]() {
-        frame2jpg_cb(fb_, 80, [](void* arg, size_t index, const void* data, size_t len) -> unsigned int {
-            auto jpeg_queue = (QueueHandle_t)arg;
-            JpegChunk chunk = {
-                .data = (uint8_t*)heap_caps_aligned_alloc(16, len, MALLOC_CAP_SPIRAM),
-                .len = len
-            };
-            memcpy(chunk.data, data, len);
-            xQueueSend(jpeg_queue, &chunk, portMAX_DELAY);
-            return len;
-        }, jpeg_queue);
-    });
+    // We spawn a thread to encode the image to JPEG, unless it is already cached
+    int64_t start_time = esp_timer_get_time();
+    bool cached = jpeg_cache_valid_;
+    if (!cached) {
+        encoder_thread_ = std::thread([this]() {
+            EncodeJpeg();
+        });
+    }
 
     auto http = Board::GetInstance().CreateHttp();
     // 构造multipart/form-data请求体
@@ -223,17 +410,14 @@ std::string Esp32Camera::Explain(const std::string& question) {
     http->SetHeader("Transfer-Encoding", "chunked");
     if (!http->Open("POST", explain_url_)) {
         ESP_LOGE(TAG, "Failed to connect to explain URL");
-        // Clear the queue
-        encoder_thread_.join();
-        JpegChunk chunk;
-        while (xQueueReceive(jpeg_queue, &chunk, portMAX_DELAY) == pdPASS) {
-            if (chunk.data != nullptr) {
-                heap_caps_free(chunk.data);
-            } else {
-                break;
+        // 等待编码完成，编码结果仍会留在缓存中
+        if (!cached) {
+            JpegChunk chunk;
+            while (xQueueReceive(filled_chunks_, &chunk, portMAX_DELAY) == pdPASS && chunk.data != nullptr) {
+                xQueueSend(free_chunks_, &chunk, portMAX_DELAY);
             }
+            encoder_thread_.join();
         }
-        vQueueDelete(jpeg_queue);
         return "{\"success\": false, \"message\": \"Failed to connect to explain URL\"}";
     }
     
@@ -258,23 +442,32 @@ std::string Esp32Camera::Explain(const std::string& question) {
 
     // 第三块：JPEG数据
     size_t total_sent = 0;
-    while (true) {
-        JpegChunk chunk;
-        if (xQueueReceive(jpeg_queue, &chunk, portMAX_DELAY) != pdPASS) {
-            ESP_LOGE(TAG, "Failed to receive JPEG chunk");
-            break;
-        }
-        if (chunk.data == nullptr) {
-            break; // The last chunk
+    if (cached) {
+        http->Write((const char*)jpeg_cache_, jpeg_cache_size_);
+        total_sent = jpeg_cache_size_;
+    } else {
+        while (true) {
+            JpegChunk chunk;
+            if (xQueueReceive(filled_chunks_, &chunk, portMAX_DELAY) != pdPASS) {
+                ESP_LOGE(TAG, "Failed to receive JPEG chunk");
+                break;
+            }
+            if (chunk.data == nullptr) {
+                break; // The last chunk
+            }
+            http->Write((const char*)chunk.data, chunk.len);
+            total_sent += chunk.len;
+            xQueueSend(free_chunks_, &chunk, portMAX_DELAY);
         }
-        http->Write((const char*)chunk.data, chunk.len);
-        total_sent += chunk.len;
-        heap_caps_free(chunk.data);
+        // Wait for the encoder thread to finish
+        encoder_thread_.join();
     }
-    // Wait for the encoder thread to finish
-    encoder_thread_.join();
-    // 清理队列
-    vQueueDelete(jpeg_queue);
+    // 只有一个帧缓冲时，照片已经缓存为 JPEG 就把帧还给驱动，让连续视觉模式继续采集
+    if (fb_ != nullptr && fb_count_ < 2 && jpeg_cache_valid_) {
+        esp_camera_fb_return(fb_);
+        fb_ = nullptr;
+    }
+    lock.unlock();
 
     {
         // 第四块：multipart尾部
@@ -295,7 +488,96 @@ std::string Esp32Camera::Explain(const std::string& question) {
 
     // Get remain task stack size
     size_t remain_stack_size = uxTaskGetStackHighWaterMark(nullptr);
-    ESP_LOGI(TAG, "Explain image size=%dx%d, compressed size=%d, remain stack size=%d, question=%s\n%s",
-        fb_->width, fb_->height, total_sent, remain_stack_size, question.c_str(), result.c_str());
+    ESP_LOGI(TAG, "Explain image size=%dx%d, compressed size=%d, %s, took %lld ms, remain stack size=%d, question=%s\n%s",
+        jpeg_width_, jpeg_height_, total_sent, cached ? "cached" : "encoded", (esp_timer_get_time() - start_time) / 1000,
+        remain_stack_size, question.c_str(), result.c_str());
     return result;
 }
+
+void Esp32Camera::ReturnStreamFrame() {
+    if (stream_fb_ != nullptr) {
+        esp_camera_fb_return(stream_fb_);
+        stream_fb_ = nullptr;
+    }
+}
+
+bool Esp32Camera::CaptureStreamFrame(uint8_t* luma, int luma_width, int luma_height) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ReturnStreamFrame();
+    // fb_ 和 JPEG 缓存属于拍照，这里只使用 stream_fb_。
+    // 只有一个帧缓冲时照片占着它，等识图完成（或照片过期）后再采集
+    if (fb_ != nullptr && fb_count_ < 2) {
+        if (esp_timer_get_time() - capture_time_ < PHOTO_HOLD_TIMEOUT_MS * 1000LL) {
+            return false;
+        }
+        esp_camera_fb_return(fb_);
+        fb_ = nullptr;
+    }
+    stream_fb_ = esp_camera_fb_get();
+    if (stream_fb_ == nullptr) {
+        ESP_LOGE(TAG, "Camera capture failed");
+        return false;
+    }
+    if (stream_fb_->format != PIXFORMAT_RGB565) {
+        ReturnStreamFrame();
+        return false;
+    }
+
+    // 每个格子取中心像素的亮度，Y = (77R + 150G + 29B) / 256
+    auto src = (const uint16_t*)stream_fb_->buf;
+    for (int gy = 0; gy < luma_height; gy++) {
+        int y = (gy * 2 + 1) * stream_fb_->height / (luma_height * 2);
+        for (int gx = 0; gx < luma_width; gx++) {
+            int x = (gx * 2 + 1) * stream_fb_->width / (luma_width * 2);
+            uint16_t p = __builtin_bswap16(src[y * stream_fb_->width + x]);
+            uint32_t r = (p >> 8) & 0xF8;
+            uint32_t g = (p >> 3) & 0xFC;
+            uint32_t b = (p << 3) & 0xF8;
+            *luma++ = (r * 77 + g * 150 + b * 29) >> 8;
+        }
+    }
+    return true;
+}
+
+bool Esp32Camera::EncodeStreamFrame(std::vector<uint8_t>& jpeg, int max_width, int quality) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stream_fb_ == nullptr || stream_fb_->format != PIXFORMAT_RGB565) {
+        return false;
+    }
+
+    uint8_t* src = stream_fb_->buf;
+    size_t src_len = stream_fb_->len;
+    int width = stream_fb_->width;
+    int height = stream_fb_->height;
+    int factor = 1;
+    while (stream_fb_->width / factor > max_width) {
+        factor *= 2;
+    }
+    uint8_t* scaled = nullptr;
+    if (factor > 1) {
+        width = stream_fb_->width / factor;
+        height = stream_fb_->height / factor;
+        scaled = (uint8_t*)heap_caps_malloc(width * height * 2, MALLOC_CAP_SPIRAM);
+        if (scaled == nullptr) {
+            ESP_LOGE(TAG, "Failed to allocate downscale buffer");
+            return false;
+        }
+        DownscaleRgb565(stream_fb_->buf, stream_fb_->width, scaled, width, height, factor);
+        src = scaled;
+        src_len = width * height * 2;
+    }
+
+    jpeg.clear();
+    bool success = fmt2jpg_cb(src, src_len, width, height, PIXFORMAT_RGB565, quality,
+        [](void* arg, size_t index, const void* data, size_t len) -> unsigned int {
+            if (data != nullptr && len > 0) {
+                auto jpeg = (std::vector<uint8_t>*)arg;
+                jpeg->insert(jpeg->end(), (const uint8_t*)data, (const uint8_t*)data + len);
+            }
+            return len;
+        }, &jpeg);
+    if (scaled != nullptr) {
+        heap_caps_free(scaled);
+    }
+    return success && !jpeg.empty();
+}
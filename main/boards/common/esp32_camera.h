@@ -5,11 +5,13 @@
 #include <lvgl.h>
 #include <thread>
 #include <memory>
+#include <mutex>
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/queue.h>
 
 #include "camera.h"
+#include "preview_image.h"
 
 struct JpegChunk {
     uint8_t* data;
@@ -18,12 +20,35 @@ struct JpegChunk {
 
 class Esp32Camera : public Camera {
 private:
+    // fb_ 是拍照得到的一帧，供识图使用；stream_fb_ 是连续视觉模式和画面检测抓取的一帧
+    std::mutex mutex_;
     camera_fb_t* fb_ = nullptr;
-    lv_img_dsc_t preview_image_;
+    camera_fb_t* stream_fb_ = nullptr;
+    int fb_count_ = 1;
+    int64_t capture_time_ = 0;
+    std::unique_ptr<PreviewImagePool> preview_pool_;
     std::string explain_url_;
     std::string explain_token_;
     std::thread encoder_thread_;
 
+    // JPEG 按拍照缓存，同一张照片多次提问时不再重新编码
+    uint8_t* jpeg_cache_ = nullptr;
+    size_t jpeg_cache_size_ = 0;
+    size_t jpeg_cache_capacity_ = 0;
+    bool jpeg_cache_valid_ = false;
+    int jpeg_width_ = 0;
+    int jpeg_height_ = 0;
+
+    // 编码线程与上传之间使用固定的缓冲区环，不再为每个分块申请内存
+    uint8_t* upload_buffers_ = nullptr;
+    QueueHandle_t free_chunks_ = nullptr;
+    QueueHandle_t filled_chunks_ = nullptr;
+    JpegChunk upload_chunk_ = {};
+
+    void EncodeJpeg();
+    void OnJpegData(const uint8_t* data, size_t len);
+    void ReturnStreamFrame();
+
 public:
     Esp32Camera(const camera_config_t& config);
     ~Esp32Camera();
@@ -34,6 +59,8 @@ public:
     virtual bool SetHMirror(bool enabled) override;
     virtual bool SetVFlip(bool enabled) override;
     virtual std::string Explain(const std::string& question);
+    virtual bool CaptureStreamFrame(uint8_t* luma, int luma_width, int luma_height) override;
+    virtual bool EncodeStreamFrame(std::vector<uint8_t>& jpeg, int max_width, int quality) override;
 };
 
 #endif // ESP32_CAMERA_H
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "power_save_timer.h"
 #include "application.h"
+#include "settings.h"
 
 #include <esp_log.h>
 
@@ -78,6 +79,8 @@ void PowerSaveTimer::PowerSaveCheck() {
         }
     }
     if (seconds_to_shutdown_ != -1 && ticks_ >= seconds_to_shutdown_ && on_shutdown_request_) {
+        // 深度睡眠与关机不会调用 esp_restart 的 shutdown handler，先写回设置
+        Settings::Flush();
         on_shutdown_request_();
     }
 }
@@ -88,12 +91,28 @@ void PowerSaveTimer::WakeUp() {
         in_sleep_mode_ = false;
 
         if (cpu_max_freq_ != -1) {
+#if CONFIG_USE_IDLE_LISTENING_PM
+            // Application 在对话期间持有最高频率锁，这里保持动态调频，有 tickless idle 时允许自动浅睡眠
+            esp_pm_config_t pm_config = {
+                .max_freq_mhz = cpu_max_freq_,
+                .min_freq_mhz = 40,
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+                .light_sleep_enable = true,
+#else
+                .light_sleep_enable = false,
+#endif
+            };
+#else
             esp_pm_config_t pm_config = {
                 .max_freq_mhz = cpu_max_freq_,
                 .min_freq_mhz = cpu_max_freq_,
                 .light_sleep_enable = false,
             };
-            esp_pm_configure(&pm_config);
+#endif
+            esp_err_t err = esp_pm_configure(&pm_config);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to configure power management: %s", esp_err_to_name(err));
+            }
         }
 
         if (on_exit_sleep_mode_) {
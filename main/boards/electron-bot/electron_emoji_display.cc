@@ -107,10 +107,10 @@ void ElectronEmojiDisplay::SetupGifContainer() {
 
     lv_obj_align(chat_message_label_, LV_ALIGN_BOTTOM_MID, 0, 0);
 
-    LcdDisplay::SetTheme("dark");
+    LcdDisplay::RenderTheme("dark");
 }
 
-void ElectronEmojiDisplay::SetEmotion(const char* emotion) {
+void ElectronEmojiDisplay::RenderEmotion(const char* emotion) {
     if (!emotion || !emotion_gif_) {
         return;
     }
@@ -129,7 +129,7 @@ void ElectronEmojiDisplay::SetEmotion(const char* emotion) {
     ESP_LOGI(TAG, "未知表情'%s'，使用默认", emotion);
 }
 
-void ElectronEmojiDisplay::SetChatMessage(const char* role, const char* content) {
+void ElectronEmojiDisplay::RenderChatMessage(const char* role, const char* content) {
     DisplayLockGuard lock(this);
     if (chat_message_label_ == nullptr) {
         return;
@@ -146,7 +146,7 @@ void ElectronEmojiDisplay::SetChatMessage(const char* role, const char* content)
     ESP_LOGI(TAG, "设置聊天消息 [%s]: %s", role, content);
 }
 
-void ElectronEmojiDisplay::SetIcon(const char* icon) {
+void ElectronEmojiDisplay::RenderIcon(const char* icon) {
     if (!icon) {
         return;
     }
@@ -20,6 +20,7 @@
 #include "power_manager.h"
 #include "power_controller.h"
 #include "gpio_manager.h"
+#include "settings.h"
 #include <driver/rtc_io.h>
 #include <esp_sleep.h>
 
@@ -97,6 +98,7 @@ private:
         });
         power_save_timer_->OnShutdownRequest([this]() {
             ESP_LOGI(TAG, "Shutting down");
+            Settings::Flush();
             #ifndef __USER_GPIO_PWRDOWN__
             ESP_ERROR_CHECK(esp_sleep_enable_ext0_wakeup(PWR_BUTTON_GPIO, 0));
             ESP_ERROR_CHECK(rtc_gpio_pullup_en(PWR_BUTTON_GPIO));  // 内部上拉
@@ -197,6 +199,8 @@ private:
             switch(newState) {
                 case PowerController::PowerState::SHUTDOWN: {
                     ESP_LOGI(TAG, "Entering shutdown sequence");
+                    // 下面会断电或进入深度睡眠，都不会调用 esp_restart 的 shutdown handler
+                    Settings::Flush();
                     
                     // 统一唤醒触发条件
                     #ifndef __USER_GPIO_PWRDOWN__
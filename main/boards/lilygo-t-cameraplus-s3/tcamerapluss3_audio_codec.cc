@@ -51,8 +51,12 @@ void Tcamerapluss3AudioCodec::CreateVoiceHardware(gpio_num_t mic_bclk, gpio_num_
     gpio_num_t spkr_bclk, gpio_num_t spkr_lrclk, gpio_num_t spkr_data) {
     
     i2s_chan_config_t mic_chan_config = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_0, I2S_ROLE_MASTER);
+    mic_chan_config.dma_desc_num = dma_desc_num_;
+    mic_chan_config.dma_frame_num = dma_frame_num_;
     mic_chan_config.auto_clear = true; // Auto clear the legacy data in the DMA buffer
     i2s_chan_config_t spkr_chan_config = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_1, I2S_ROLE_MASTER);
+    spkr_chan_config.dma_desc_num = dma_desc_num_;
+    spkr_chan_config.dma_frame_num = dma_frame_num_;
     spkr_chan_config.auto_clear = true; // Auto clear the legacy data in the DMA buffer
 
     ESP_ERROR_CHECK(i2s_new_channel(&mic_chan_config, NULL, &rx_handle_));
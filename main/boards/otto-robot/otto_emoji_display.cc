@@ -108,10 +108,10 @@ void OttoEmojiDisplay::SetupGifContainer() {
 
     lv_obj_align(chat_message_label_, LV_ALIGN_BOTTOM_MID, 0, 0);
 
-    LcdDisplay::SetTheme("dark");
+    LcdDisplay::RenderTheme("dark");
 }
 
-void OttoEmojiDisplay::SetEmotion(const char* emotion) {
+void OttoEmojiDisplay::RenderEmotion(const char* emotion) {
     if (!emotion || !emotion_gif_) {
         return;
     }
@@ -130,7 +130,7 @@ void OttoEmojiDisplay::SetEmotion(const char* emotion) {
     ESP_LOGI(TAG, "未知表情'%s'，使用默认", emotion);
 }
 
-void OttoEmojiDisplay::SetChatMessage(const char* role, const char* content) {
+void OttoEmojiDisplay::RenderChatMessage(const char* role, const char* content) {
     DisplayLockGuard lock(this);
     if (chat_message_label_ == nullptr) {
         return;
@@ -147,7 +147,7 @@ void OttoEmojiDisplay::SetChatMessage(const char* role, const char* content) {
     ESP_LOGI(TAG, "设置聊天消息 [%s]: %s", role, content);
 }
 
-void OttoEmojiDisplay::SetIcon(const char* icon) {
+void OttoEmojiDisplay::RenderIcon(const char* icon) {
     if (!icon) {
         return;
     }
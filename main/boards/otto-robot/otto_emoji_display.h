@@ -20,14 +20,15 @@ public:
 
     virtual ~OttoEmojiDisplay() = default;
 
+protected:
     // 重写表情设置方法
-    virtual void SetEmotion(const char* emotion) override;
+    virtual void RenderEmotion(const char* emotion) override;
 
     // 重写聊天消息设置方法
-    virtual void SetChatMessage(const char* role, const char* content) override;
+    virtual void RenderChatMessage(const char* role, const char* content) override;
 
-    // 添加SetIcon方法声明
-    virtual void SetIcon(const char* icon) override;
+    // 添加RenderIcon方法声明
+    virtual void RenderIcon(const char* icon) override;
 
 private:
     void SetupGifContainer();
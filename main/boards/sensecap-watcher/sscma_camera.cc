@@ -7,6 +7,7 @@
 
 #include <esp_log.h>
 #include <esp_heap_caps.h>
+#include <esp_timer.h>
 #include <img_converters.h>
 #include <cstring>
 
@@ -132,28 +133,11 @@ SscmaCamera::SscmaCamera(esp_io_expander_handle_t io_exp_handle) {
     }
     memset(jpeg_out_, 0, sizeof(jpeg_dec_header_info_t));
 
-    // 初始化预览图片的内存
-    memset(&preview_image_, 0, sizeof(preview_image_));
-    preview_image_.header.magic = LV_IMAGE_HEADER_MAGIC;
-    preview_image_.header.cf = LV_COLOR_FORMAT_RGB565;
-    preview_image_.header.flags = LV_IMAGE_FLAGS_ALLOCATED | LV_IMAGE_FLAGS_MODIFIABLE;
-    preview_image_.header.w = 640;
-    preview_image_.header.h = 480;
-
-    preview_image_.header.stride = preview_image_.header.w * 2;
-    preview_image_.data_size = preview_image_.header.w * preview_image_.header.h * 2;
-    preview_image_.data = (uint8_t*)heap_caps_malloc(preview_image_.data_size, MALLOC_CAP_SPIRAM);
-    if (preview_image_.data == nullptr) {
-        ESP_LOGE(TAG, "Failed to allocate memory for preview image");
-        return;
-    }
+    // 预览图片按需分配，显示端引用同一块内存，不再拷贝
+    preview_pool_ = std::make_unique<PreviewImagePool>(640, 480);
 }
 
 SscmaCamera::~SscmaCamera() {
-    if (preview_image_.data) {
-        heap_caps_free((void*)preview_image_.data);
-        preview_image_.data = nullptr;
-    }
     if (sscma_client_handle_) {
         sscma_client_del(sscma_client_handle_);
     }
@@ -195,6 +179,7 @@ bool SscmaCamera::Capture() {
     }
 
     ESP_LOGI(TAG, "Capturing image...");
+    int64_t start_time = esp_timer_get_time();
 
     // himax 有缓存数据,需要拍两张照片, 只获取最新的照片即可.
     if (sscma_client_sample(sscma_client_handle_, 2) ) {
@@ -221,7 +206,11 @@ bool SscmaCamera::Capture() {
     heap_caps_free(data.img);
 
     //DECODE JPEG
-    if (!jpeg_dec_ || !jpeg_io_ || !jpeg_out_ || !preview_image_.data) {
+    if (!jpeg_dec_ || !jpeg_io_ || !jpeg_out_ || !preview_pool_) {
+        return true;
+    }
+    auto image = preview_pool_->Acquire();
+    if (image == nullptr) {
         return true;
     }
     jpeg_io_->inbuf = jpeg_data_.buf;
@@ -231,7 +220,7 @@ bool SscmaCamera::Capture() {
         ESP_LOGE(TAG, "Failed to parse JPEG header, ret: %d", ret);
         return true;
     }
-    jpeg_io_->outbuf = (unsigned char*)preview_image_.data;
+    jpeg_io_->outbuf = image->data();
     int inbuf_consumed = jpeg_io_->inbuf_len - jpeg_io_->inbuf_remain;
     jpeg_io_->inbuf =  jpeg_data_.buf + inbuf_consumed;
     jpeg_io_->inbuf_len = jpeg_io_->inbuf_remain;
@@ -245,7 +234,8 @@ bool SscmaCamera::Capture() {
     // 显示预览图片
     auto display = Board::GetInstance().GetDisplay();
     if (display != nullptr) {
-        display->SetPreviewImage(&preview_image_);
+        image->set_capture_time(start_time);
+        display->SetPreviewImage(image);
     }
     return true;
 }
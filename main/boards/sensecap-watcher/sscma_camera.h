@@ -13,6 +13,7 @@
 
 #include "sscma_client.h"
 #include "camera.h"
+#include "preview_image.h"
 
 struct SscmaData {
     uint8_t* img;
@@ -25,7 +26,7 @@ struct JpegData {
 
 class SscmaCamera : public Camera {
 private:
-    lv_img_dsc_t preview_image_;
+    std::unique_ptr<PreviewImagePool> preview_pool_;
     std::string explain_url_;
     std::string explain_token_;
     sscma_client_io_handle_t sscma_client_io_handle_;
@@ -0,0 +1,66 @@
+#include "boot_report.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <algorithm>
+#include <cstring>
+
+#define TAG "BootReport"
+
+void BootReport::Begin(const char* stage) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stages_.push_back({
+        .name = stage,
+        .begin_us = esp_timer_get_time(),
+        .end_us = -1,
+        .task = pcTaskGetName(NULL)
+    });
+}
+
+void BootReport::End(const char* stage) {
+    auto now = esp_timer_get_time();
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(stages_.rbegin(), stages_.rend(), [stage](const Stage& s) {
+        return s.end_us < 0 && strcmp(s.name, stage) == 0;
+    });
+    if (it == stages_.rend()) {
+        ESP_LOGW(TAG, "Stage %s was not started", stage);
+        return;
+    }
+    it->end_us = now;
+}
+
+void BootReport::Mark(const char* event) {
+    auto now = esp_timer_get_time();
+    std::lock_guard<std::mutex> lock(mutex_);
+    stages_.push_back({
+        .name = event,
+        .begin_us = now,
+        .end_us = now,
+        .task = pcTaskGetName(NULL)
+    });
+}
+
+void BootReport::Print() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (printed_) {
+        return;
+    }
+    printed_ = true;
+
+    std::sort(stages_.begin(), stages_.end(), [](const Stage& a, const Stage& b) {
+        return a.begin_us < b.begin_us;
+    });
+    ESP_LOGI(TAG, "%-16s %8s %8s %8s  %s", "stage", "begin", "end", "ms", "task");
+    for (auto& stage : stages_) {
+        if (stage.end_us < 0) {
+            ESP_LOGI(TAG, "%-16s %8lld %8s %8s  %s", stage.name, stage.begin_us / 1000, "-", "-", stage.task.c_str());
+        } else {
+            ESP_LOGI(TAG, "%-16s %8lld %8lld %8lld  %s", stage.name, stage.begin_us / 1000, stage.end_us / 1000,
+                (stage.end_us - stage.begin_us) / 1000, stage.task.c_str());
+        }
+    }
+}
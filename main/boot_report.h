@@ -0,0 +1,42 @@
+#ifndef BOOT_REPORT_H
+#define BOOT_REPORT_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 记录启动各阶段的开始与结束时间（esp_timer 时间，从应用启动开始计时），
+// 设备进入空闲后打印启动报告。阶段可以在不同任务中并行执行
+class BootReport {
+public:
+    static BootReport& GetInstance() {
+        static BootReport instance;
+        return instance;
+    }
+    BootReport(const BootReport&) = delete;
+    BootReport& operator=(const BootReport&) = delete;
+
+    // stage 需要是字符串常量
+    void Begin(const char* stage);
+    void End(const char* stage);
+    // 记录一个时间点，例如唤醒词就绪
+    void Mark(const char* event);
+    void Print();
+
+private:
+    BootReport() = default;
+
+    struct Stage {
+        const char* name;
+        int64_t begin_us;
+        int64_t end_us;
+        std::string task;
+    };
+
+    std::mutex mutex_;
+    std::vector<Stage> stages_;
+    bool printed_ = false;
+};
+
+#endif // BOOT_REPORT_H
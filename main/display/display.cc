@@ -3,6 +3,7 @@
 #include <string>
 #include <cstdlib>
 #include <cstring>
+#include <algorithm>
 
 #include "display.h"
 #include "board.h"
@@ -14,14 +15,17 @@
 
 #define TAG "Display"
 
+// The LVGL refresh period, draining faster than a frame would not show the updates any sooner
+#define DISPLAY_COMMAND_PERIOD_MS 30
+// Chat messages are never coalesced, but a stalled LVGL task must not grow the queue forever
+#define MAX_PENDING_CHAT_MESSAGES 16
+
 Display::Display() {
     // Notification timer
     esp_timer_create_args_t notification_timer_args = {
         .callback = [](void *arg) {
             Display *display = static_cast<Display*>(arg);
-            DisplayLockGuard lock(display);
-            lv_obj_add_flag(display->notification_label_, LV_OBJ_FLAG_HIDDEN);
-            lv_obj_clear_flag(display->status_label_, LV_OBJ_FLAG_HIDDEN);
+            display->PostCommand(DisplayCommand{ .type = kDisplayCommandNotificationTimeout });
         },
         .arg = this,
         .dispatch_method = ESP_TIMER_TASK,
@@ -40,6 +44,9 @@ Display::Display() {
 }
 
 Display::~Display() {
+    if (command_timer_ != nullptr) {
+        lv_timer_delete(command_timer_);
+    }
     if (notification_timer_ != nullptr) {
         esp_timer_stop(notification_timer_);
         esp_timer_delete(notification_timer_);
@@ -61,7 +68,7 @@ Display::~Display() {
     }
 }
 
-void Display::SetStatus(const char* status) {
+void Display::RenderStatus(const char* status) {
     DisplayLockGuard lock(this);
     if (status_label_ == nullptr) {
         return;
@@ -71,11 +78,7 @@ void Display::SetStatus(const char* status) {
     lv_obj_add_flag(notification_label_, LV_OBJ_FLAG_HIDDEN);
 }
 
-void Display::ShowNotification(const std::string &notification, int duration_ms) {
-    ShowNotification(notification.c_str(), duration_ms);
-}
-
-void Display::ShowNotification(const char* notification, int duration_ms) {
+void Display::RenderNotification(const char* notification, int duration_ms) {
     DisplayLockGuard lock(this);
     if (notification_label_ == nullptr) {
         return;
@@ -88,24 +91,23 @@ void Display::ShowNotification(const char* notification, int duration_ms) {
     ESP_ERROR_CHECK(esp_timer_start_once(notification_timer_, duration_ms * 1000));
 }
 
+// Runs on the clock timer, so the board is queried here and only the label changes go to the LVGL task
 void Display::UpdateStatusBar(bool update_all) {
     auto& board = Board::GetInstance();
     auto codec = board.GetAudioCodec();
 
-    {
-        DisplayLockGuard lock(this);
-        if (mute_label_ == nullptr) {
-            return;
-        }
+    if (mute_label_ == nullptr) {
+        return;
+    }
+    DisplayCommand command{ .type = kDisplayCommandStatusBar };
 
-        // 如果静音状态改变，则更新图标
-        if (codec->output_volume() == 0 && !muted_) {
-            muted_ = true;
-            lv_label_set_text(mute_label_, FONT_AWESOME_VOLUME_MUTE);
-        } else if (codec->output_volume() > 0 && muted_) {
-            muted_ = false;
-            lv_label_set_text(mute_label_, "");
-        }
+    // 如果静音状态改变，则更新图标
+    if (codec->output_volume() == 0 && !muted_) {
+        muted_ = true;
+        command.mute_icon = FONT_AWESOME_VOLUME_MUTE;
+    } else if (codec->output_volume() > 0 && muted_) {
+        muted_ = false;
+        command.mute_icon = "";
     }
 
     esp_pm_lock_acquire(pm_lock_);
@@ -127,24 +129,20 @@ void Display::UpdateStatusBar(bool update_all) {
             };
             icon = levels[battery_level / 20];
         }
-        DisplayLockGuard lock(this);
         if (battery_label_ != nullptr && battery_icon_ != icon) {
             battery_icon_ = icon;
-            lv_label_set_text(battery_label_, battery_icon_);
+            command.battery_icon = battery_icon_;
         }
 
         if (low_battery_popup_ != nullptr) {
-            if (strcmp(icon, FONT_AWESOME_BATTERY_EMPTY) == 0 && discharging) {
-                if (lv_obj_has_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN)) { // 如果低电量提示框隐藏，则显示
-                    lv_obj_clear_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
+            bool show = strcmp(icon, FONT_AWESOME_BATTERY_EMPTY) == 0 && discharging;
+            if (show != low_battery_shown_) {
+                low_battery_shown_ = show;
+                command.low_battery_popup = show ? 1 : 0;
+                if (show) {
                     auto& app = Application::GetInstance();
                     app.PlaySound(Lang::Sounds::P3_LOW_BATTERY);
                 }
-            } else {
-                // Hide the low battery popup when the battery is not empty
-                if (!lv_obj_has_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN)) { // 如果低电量提示框显示，则隐藏
-                    lv_obj_add_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
-                }
             }
         }
     }
@@ -164,18 +162,184 @@ void Display::UpdateStatusBar(bool update_all) {
         if (std::find(allowed_states.begin(), allowed_states.end(), device_state) != allowed_states.end()) {
             icon = board.GetNetworkStateIcon();
             if (network_label_ != nullptr && icon != nullptr && network_icon_ != icon) {
-                DisplayLockGuard lock(this);
                 network_icon_ = icon;
-                lv_label_set_text(network_label_, network_icon_);
+                command.network_icon = network_icon_;
             }
         }
     }
 
     esp_pm_lock_release(pm_lock_);
+
+    if (command.mute_icon != nullptr || command.battery_icon != nullptr ||
+        command.network_icon != nullptr || command.low_battery_popup != -1) {
+        PostCommand(std::move(command));
+    }
 }
 
+static inline const char* OrEmpty(const char* text) {
+    return text != nullptr ? text : "";
+}
+
+void Display::SetStatus(const char* status) {
+    PostCommand(DisplayCommand{ .type = kDisplayCommandStatus, .text = OrEmpty(status) });
+}
+
+void Display::ShowNotification(const char* notification, int duration_ms) {
+    PostCommand(DisplayCommand{ .type = kDisplayCommandNotification, .text = OrEmpty(notification), .duration_ms = duration_ms });
+}
+
+void Display::ShowNotification(const std::string &notification, int duration_ms) {
+    PostCommand(DisplayCommand{ .type = kDisplayCommandNotification, .text = notification, .duration_ms = duration_ms });
+}
 
 void Display::SetEmotion(const char* emotion) {
+    PostCommand(DisplayCommand{ .type = kDisplayCommandEmotion, .text = OrEmpty(emotion) });
+}
+
+void Display::SetIcon(const char* icon) {
+    PostCommand(DisplayCommand{ .type = kDisplayCommandIcon, .text = OrEmpty(icon) });
+}
+
+void Display::SetChatMessage(const char* role, const char* content) {
+    PostCommand(DisplayCommand{ .type = kDisplayCommandChatMessage, .text = OrEmpty(content), .role = OrEmpty(role) });
+}
+
+void Display::SetPreviewImage(std::shared_ptr<PreviewImage> image) {
+    PostCommand(DisplayCommand{ .type = kDisplayCommandPreviewImage, .image = std::move(image) });
+}
+
+void Display::SetTheme(const std::string& theme_name) {
+    PostCommand(DisplayCommand{ .type = kDisplayCommandTheme, .text = theme_name });
+}
+
+// Called with commands_mutex_ held. Only displays that render through LVGL have a task to drain the queue
+void Display::StartCommandQueue() {
+    if (command_timer_ != nullptr || display_ == nullptr) {
+        return;
+    }
+    // Never wait for the LVGL task here: if it is busy, this update is applied directly and the next one tries again
+    if (!Lock(0)) {
+        return;
+    }
+    command_timer_ = lv_timer_create([](lv_timer_t* timer) {
+        auto display = static_cast<Display*>(lv_timer_get_user_data(timer));
+        display->DrainCommands();
+    }, DISPLAY_COMMAND_PERIOD_MS, this);
+    Unlock();
+}
+
+void Display::PostCommand(DisplayCommand&& command) {
+    {
+        std::lock_guard<std::mutex> lock(commands_mutex_);
+        StartCommandQueue();
+        if (command_timer_ != nullptr) {
+            // Emotion and icon share the same label, so either one replaces the other
+            auto same_target = [&command](const DisplayCommand& c) {
+                auto is_emotion = [](DisplayCommandType t) { return t == kDisplayCommandEmotion || t == kDisplayCommandIcon; };
+                return c.type == command.type || (is_emotion(c.type) && is_emotion(command.type));
+            };
+
+            if (command.type == kDisplayCommandStatusBar) {
+                // Merge into the pending status bar update, newer icons win
+                for (auto& pending : commands_) {
+                    if (pending.type == kDisplayCommandStatusBar) {
+                        if (command.mute_icon != nullptr) pending.mute_icon = command.mute_icon;
+                        if (command.battery_icon != nullptr) pending.battery_icon = command.battery_icon;
+                        if (command.network_icon != nullptr) pending.network_icon = command.network_icon;
+                        if (command.low_battery_popup != -1) pending.low_battery_popup = command.low_battery_popup;
+                        return;
+                    }
+                }
+            } else if (command.type == kDisplayCommandChatMessage) {
+                size_t chat_messages = std::count_if(commands_.begin(), commands_.end(), [](const DisplayCommand& c) {
+                    return c.type == kDisplayCommandChatMessage;
+                });
+                if (chat_messages >= MAX_PENDING_CHAT_MESSAGES) {
+                    ESP_LOGW(TAG, "Too many pending chat messages, drop the oldest one");
+                    commands_.erase(std::find_if(commands_.begin(), commands_.end(), [](const DisplayCommand& c) {
+                        return c.type == kDisplayCommandChatMessage;
+                    }));
+                }
+            } else if (command.type != kDisplayCommandNotification && command.type != kDisplayCommandPreviewImage) {
+                // The latest status / emotion fully overwrites the previous one, keep only that
+                commands_.erase(std::remove_if(commands_.begin(), commands_.end(), same_target), commands_.end());
+            }
+            commands_.push_back(std::move(command));
+            return;
+        }
+    }
+
+    // This display does not use LVGL, or LVGL is not set up yet, apply it right away
+    ApplyCommand(command);
+}
+
+void Display::DrainCommands() {
+    std::deque<DisplayCommand> commands;
+    {
+        std::lock_guard<std::mutex> lock(commands_mutex_);
+        if (commands_.empty()) {
+            return;
+        }
+        commands.swap(commands_);
+    }
+    for (auto& command : commands) {
+        ApplyCommand(command);
+    }
+}
+
+void Display::ApplyCommand(const DisplayCommand& command) {
+    switch (command.type) {
+    case kDisplayCommandStatus:
+        RenderStatus(command.text.c_str());
+        break;
+    case kDisplayCommandNotification:
+        RenderNotification(command.text.c_str(), command.duration_ms);
+        break;
+    case kDisplayCommandNotificationTimeout: {
+        DisplayLockGuard lock(this);
+        if (notification_label_ != nullptr) {
+            lv_obj_add_flag(notification_label_, LV_OBJ_FLAG_HIDDEN);
+            lv_obj_clear_flag(status_label_, LV_OBJ_FLAG_HIDDEN);
+        }
+        break;
+    }
+    case kDisplayCommandEmotion:
+        RenderEmotion(command.text.c_str());
+        break;
+    case kDisplayCommandIcon:
+        RenderIcon(command.text.c_str());
+        break;
+    case kDisplayCommandChatMessage:
+        RenderChatMessage(command.role.c_str(), command.text.c_str());
+        break;
+    case kDisplayCommandPreviewImage:
+        RenderPreviewImage(command.image);
+        break;
+    case kDisplayCommandTheme:
+        RenderTheme(command.text);
+        break;
+    case kDisplayCommandStatusBar: {
+        DisplayLockGuard lock(this);
+        if (command.mute_icon != nullptr && mute_label_ != nullptr) {
+            lv_label_set_text(mute_label_, command.mute_icon);
+        }
+        if (command.battery_icon != nullptr && battery_label_ != nullptr) {
+            lv_label_set_text(battery_label_, command.battery_icon);
+        }
+        if (command.network_icon != nullptr && network_label_ != nullptr) {
+            lv_label_set_text(network_label_, command.network_icon);
+        }
+        if (command.low_battery_popup == 1) {
+            lv_obj_clear_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
+        } else if (command.low_battery_popup == 0) {
+            lv_obj_add_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
+        }
+        break;
+    }
+    }
+}
+
+void Display::RenderEmotion(const char* emotion) {
     struct Emotion {
         const char* icon;
         const char* text;
@@ -223,7 +387,7 @@ void Display::SetEmotion(const char* emotion) {
     }
 }
 
-void Display::SetIcon(const char* icon) {
+void Display::RenderIcon(const char* icon) {
     DisplayLockGuard lock(this);
     if (emotion_label_ == nullptr) {
         return;
@@ -231,11 +395,11 @@ void Display::SetIcon(const char* icon) {
     lv_label_set_text(emotion_label_, icon);
 }
 
-void Display::SetPreviewImage(const lv_img_dsc_t* image) {
+void Display::RenderPreviewImage(std::shared_ptr<PreviewImage> image) {
     // Do nothing
 }
 
-void Display::SetChatMessage(const char* role, const char* content) {
+void Display::RenderChatMessage(const char* role, const char* content) {
     DisplayLockGuard lock(this);
     if (chat_message_label_ == nullptr) {
         return;
@@ -243,7 +407,7 @@ void Display::SetChatMessage(const char* role, const char* content) {
     lv_label_set_text(chat_message_label_, content);
 }
 
-void Display::SetTheme(const std::string& theme_name) {
+void Display::RenderTheme(const std::string& theme_name) {
     current_theme_name_ = theme_name;
     Settings settings("display", true);
     settings.SetString("theme", theme_name);
@@ -7,6 +7,11 @@
 #include <esp_pm.h>
 
 #include <string>
+#include <deque>
+#include <mutex>
+#include <memory>
+
+#include "preview_image.h"
 
 struct DisplayFonts {
     const lv_font_t* text_font = nullptr;
@@ -14,19 +19,48 @@ struct DisplayFonts {
     const lv_font_t* emoji_font = nullptr;
 };
 
+enum DisplayCommandType {
+    kDisplayCommandStatus,
+    kDisplayCommandNotification,
+    kDisplayCommandNotificationTimeout,
+    kDisplayCommandEmotion,
+    kDisplayCommandIcon,
+    kDisplayCommandChatMessage,
+    kDisplayCommandPreviewImage,
+    kDisplayCommandTheme,
+    kDisplayCommandStatusBar,
+};
+
+// A display update waiting to be applied by the LVGL task
+struct DisplayCommand {
+    DisplayCommandType type;
+    std::string text;
+    std::string role;
+    int duration_ms = 0;
+    std::shared_ptr<PreviewImage> image;
+    // Status bar icons, nullptr means unchanged
+    const char* mute_icon = nullptr;
+    const char* battery_icon = nullptr;
+    const char* network_icon = nullptr;
+    int low_battery_popup = -1; // -1 unchanged, 0 hide, 1 show
+};
+
 class Display {
 public:
     Display();
     virtual ~Display();
 
-    virtual void SetStatus(const char* status);
-    virtual void ShowNotification(const char* notification, int duration_ms = 3000);
-    virtual void ShowNotification(const std::string &notification, int duration_ms = 3000);
-    virtual void SetEmotion(const char* emotion);
-    virtual void SetChatMessage(const char* role, const char* content);
-    virtual void SetIcon(const char* icon);
-    virtual void SetPreviewImage(const lv_img_dsc_t* image);
-    virtual void SetTheme(const std::string& theme_name);
+    // Updates never wait for rendering: they are queued and applied by the LVGL task, and repeated
+    // status, emotion, icon and theme updates between two drains collapse into the latest one.
+    // A null text is shown as an empty string.
+    void SetStatus(const char* status);
+    void ShowNotification(const char* notification, int duration_ms = 3000);
+    void ShowNotification(const std::string &notification, int duration_ms = 3000);
+    void SetEmotion(const char* emotion);
+    void SetChatMessage(const char* role, const char* content);
+    void SetIcon(const char* icon);
+    void SetPreviewImage(std::shared_ptr<PreviewImage> image);
+    void SetTheme(const std::string& theme_name);
     virtual std::string GetTheme() { return current_theme_name_; }
     virtual void UpdateStatusBar(bool update_all = false);
 
@@ -53,13 +87,34 @@ protected:
     const char* battery_icon_ = nullptr;
     const char* network_icon_ = nullptr;
     bool muted_ = false;
+    bool low_battery_shown_ = false;
     std::string current_theme_name_;
 
     esp_timer_handle_t notification_timer_ = nullptr;
 
+    // The actual rendering, called on the LVGL task. Displays that do not render through LVGL
+    // (display_ is not set), and LVGL displays before their first queued update, call them directly.
+    virtual void RenderStatus(const char* status);
+    virtual void RenderNotification(const char* notification, int duration_ms);
+    virtual void RenderEmotion(const char* emotion);
+    virtual void RenderChatMessage(const char* role, const char* content);
+    virtual void RenderIcon(const char* icon);
+    virtual void RenderPreviewImage(std::shared_ptr<PreviewImage> image);
+    virtual void RenderTheme(const std::string& theme_name);
+
     friend class DisplayLockGuard;
     virtual bool Lock(int timeout_ms = 0) = 0;
     virtual void Unlock() = 0;
+
+private:
+    std::mutex commands_mutex_;
+    std::deque<DisplayCommand> commands_;
+    lv_timer_t* command_timer_ = nullptr;
+
+    void StartCommandQueue();
+    void PostCommand(DisplayCommand&& command);
+    void ApplyCommand(const DisplayCommand& command);
+    void DrainCommands();
 };
 
 
@@ -303,6 +303,24 @@ void LcdDisplay::Unlock() {
     lvgl_port_unlock();
 }
 
+void LcdDisplay::AddRenderLatencyCallback() {
+    // Report how long it takes until the frame containing a new chat message or preview is flushed
+    lv_display_add_event_cb(display_, [](lv_event_t* e) {
+        auto self = static_cast<LcdDisplay*>(lv_event_get_user_data(e));
+        auto now = esp_timer_get_time();
+#if CONFIG_USE_WECHAT_MESSAGE_STYLE
+        if (self->chat_render_start_time_ != 0) {
+            ESP_LOGI(TAG, "Chat message rendered in %lld ms", (now - self->chat_render_start_time_) / 1000);
+            self->chat_render_start_time_ = 0;
+        }
+#endif
+        if (self->preview_render_start_time_ != 0) {
+            ESP_LOGI(TAG, "Preview image rendered %lld ms after capture", (now - self->preview_render_start_time_) / 1000);
+            self->preview_render_start_time_ = 0;
+        }
+    }, LV_EVENT_REFR_READY, this);
+}
+
 #if CONFIG_USE_WECHAT_MESSAGE_STYLE
 void LcdDisplay::SetupUI() {
     DisplayLockGuard lock(this);
@@ -347,8 +365,9 @@ void LcdDisplay::SetupUI() {
     lv_obj_set_flex_align(content_, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_START);
     lv_obj_set_style_pad_row(content_, 10, 0); // Space between messages
 
-    // We'll create chat messages dynamically in SetChatMessage
+    // Chat bubbles are pre-created and recycled by RenderChatMessage
     chat_message_label_ = nullptr;
+    CreateChatSlots();
 
     /* Status bar */
     lv_obj_set_flex_flow(status_bar_, LV_FLEX_FLOW_ROW);
@@ -412,65 +431,80 @@ void LcdDisplay::SetupUI() {
     lv_obj_set_style_text_color(low_battery_label_, lv_color_white(), 0);
     lv_obj_center(low_battery_label_);
     lv_obj_add_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
+
+    AddRenderLatencyCallback();
 }
 #if CONFIG_IDF_TARGET_ESP32P4
 #define  MAX_MESSAGES 40
 #else
 #define  MAX_MESSAGES 20
 #endif
-void LcdDisplay::SetChatMessage(const char* role, const char* content) {
+// Messages arriving closer than this are part of a stream, skip the scroll animation
+#define  CHAT_SCROLL_IDLE_MS 1000
+
+void LcdDisplay::CreateChatSlots() {
+    chat_slots_.resize(MAX_MESSAGES);
+    for (auto& slot : chat_slots_) {
+        // A full-width transparent row lets the bubble align left, right or center
+        slot.row = lv_obj_create(content_);
+        lv_obj_set_width(slot.row, LV_HOR_RES);
+        lv_obj_set_height(slot.row, LV_SIZE_CONTENT);
+        lv_obj_set_style_bg_opa(slot.row, LV_OPA_TRANSP, 0);
+        lv_obj_set_style_border_width(slot.row, 0, 0);
+        lv_obj_set_style_pad_all(slot.row, 0, 0);
+        lv_obj_set_scrollbar_mode(slot.row, LV_SCROLLBAR_MODE_OFF);
+        lv_obj_add_flag(slot.row, LV_OBJ_FLAG_HIDDEN);
+
+        slot.bubble = lv_obj_create(slot.row);
+        lv_obj_set_style_radius(slot.bubble, 8, 0);
+        lv_obj_set_scrollbar_mode(slot.bubble, LV_SCROLLBAR_MODE_OFF);
+        lv_obj_set_style_border_width(slot.bubble, 1, 0);
+        lv_obj_set_style_border_color(slot.bubble, current_theme_.border, 0);
+        lv_obj_set_style_pad_all(slot.bubble, 8, 0);
+        lv_obj_set_size(slot.bubble, LV_SIZE_CONTENT, LV_SIZE_CONTENT);
+        lv_obj_set_user_data(slot.bubble, (void*)"assistant");
+
+        slot.label = lv_label_create(slot.bubble);
+        lv_label_set_long_mode(slot.label, LV_LABEL_LONG_WRAP);
+        lv_obj_set_style_text_font(slot.label, fonts_.text_font, 0);
+        lv_label_set_text(slot.label, "");
+    }
+}
+
+void LcdDisplay::RenderChatMessage(const char* role, const char* content) {
     DisplayLockGuard lock(this);
-    if (content_ == nullptr) {
+    if (content_ == nullptr || chat_slots_.empty()) {
         return;
     }
     
     //避免出现空的消息框
     if(strlen(content) == 0) return;
-    
-    // 检查消息数量是否超过限制
-    uint32_t child_count = lv_obj_get_child_cnt(content_);
-    if (child_count >= MAX_MESSAGES) {
-        // 删除最早的消息（第一个子对象）
-        lv_obj_t* first_child = lv_obj_get_child(content_, 0);
-        lv_obj_t* last_child = lv_obj_get_child(content_, child_count - 1);
-        if (first_child != nullptr) {
-            lv_obj_del(first_child);
-        }
-        // Scroll to the last message immediately
-        if (last_child != nullptr) {
-            lv_obj_scroll_to_view_recursive(last_child, LV_ANIM_OFF);
-        }
+
+    auto now = esp_timer_get_time();
+    bool streaming = last_chat_message_time_ != 0 && now - last_chat_message_time_ < CHAT_SCROLL_IDLE_MS * 1000;
+    last_chat_message_time_ = now;
+    if (chat_render_start_time_ == 0) {
+        chat_render_start_time_ = now;
     }
-    
-    // 折叠系统消息（如果是系统消息，检查最后一个消息是否也是系统消息）
-    if (strcmp(role, "system") == 0 && child_count > 0) {
-        // 获取最后一个消息容器
-        lv_obj_t* last_container = lv_obj_get_child(content_, child_count - 1);
-        if (last_container != nullptr && lv_obj_get_child_cnt(last_container) > 0) {
-            // 获取容器内的气泡
-            lv_obj_t* last_bubble = lv_obj_get_child(last_container, 0);
-            if (last_bubble != nullptr) {
-                // 检查气泡类型是否为系统消息
-                void* bubble_type_ptr = lv_obj_get_user_data(last_bubble);
-                if (bubble_type_ptr != nullptr && strcmp((const char*)bubble_type_ptr, "system") == 0) {
-                    // 如果最后一个消息也是系统消息，则删除它
-                    lv_obj_del(last_container);
-                }
-            }
+
+    // 折叠系统消息：如果最后一条也是系统消息，则直接复用它
+    ChatSlot* slot = nullptr;
+    if (strcmp(role, "system") == 0 && last_chat_slot_ != nullptr) {
+        void* bubble_type_ptr = lv_obj_get_user_data(last_chat_slot_->bubble);
+        if (bubble_type_ptr != nullptr && strcmp((const char*)bubble_type_ptr, "system") == 0) {
+            slot = last_chat_slot_;
         }
     }
-    
-    // Create a message bubble
-    lv_obj_t* msg_bubble = lv_obj_create(content_);
-    lv_obj_set_style_radius(msg_bubble, 8, 0);
-    lv_obj_set_scrollbar_mode(msg_bubble, LV_SCROLLBAR_MODE_OFF);
-    lv_obj_set_style_border_width(msg_bubble, 1, 0);
-    lv_obj_set_style_border_color(msg_bubble, current_theme_.border, 0);
-    lv_obj_set_style_pad_all(msg_bubble, 8, 0);
-
-    // Create the message text
-    lv_obj_t* msg_text = lv_label_create(msg_bubble);
-    lv_label_set_text(msg_text, content);
+    if (slot == nullptr) {
+        // Recycle the oldest slot and move it to the bottom of the chat
+        slot = &chat_slots_[next_chat_slot_];
+        next_chat_slot_ = (next_chat_slot_ + 1) % chat_slots_.size();
+        lv_obj_move_to_index(slot->row, -1);
+        lv_obj_clear_flag(slot->row, LV_OBJ_FLAG_HIDDEN);
+    }
+    last_chat_slot_ = slot;
+
+    lv_label_set_text(slot->label, content);
     
     // 计算文本实际宽度
     lv_coord_t text_width = lv_txt_get_width(content, strlen(content), fonts_.text_font, 0);
@@ -478,136 +512,54 @@ void LcdDisplay::SetChatMessage(const char* role, const char* content) {
     // 计算气泡宽度
     lv_coord_t max_width = LV_HOR_RES * 85 / 100 - 16;  // 屏幕宽度的85%
     lv_coord_t min_width = 20;  
-    lv_coord_t bubble_width;
     
     // 确保文本宽度不小于最小宽度
     if (text_width < min_width) {
         text_width = min_width;
     }
-
-    // 如果文本宽度小于最大宽度，使用文本宽度
-    if (text_width < max_width) {
-        bubble_width = text_width; 
-    } else {
-        bubble_width = max_width;
-    }
-    
-    // 设置消息文本的宽度
-    lv_obj_set_width(msg_text, bubble_width);  // 减去padding
-    lv_label_set_long_mode(msg_text, LV_LABEL_LONG_WRAP);
-    lv_obj_set_style_text_font(msg_text, fonts_.text_font, 0);
-
-    // 设置气泡宽度
-    lv_obj_set_width(msg_bubble, bubble_width);
-    lv_obj_set_height(msg_bubble, LV_SIZE_CONTENT);
+    lv_obj_set_width(slot->label, text_width < max_width ? text_width : max_width);
 
     // Set alignment and style based on message role
     if (strcmp(role, "user") == 0) {
         // User messages are right-aligned with green background
-        lv_obj_set_style_bg_color(msg_bubble, current_theme_.user_bubble, 0);
-        // Set text color for contrast
-        lv_obj_set_style_text_color(msg_text, current_theme_.text, 0);
-        
-        // 设置自定义属性标记气泡类型
-        lv_obj_set_user_data(msg_bubble, (void*)"user");
-        
-        // Set appropriate width for content
-        lv_obj_set_width(msg_bubble, LV_SIZE_CONTENT);
-        lv_obj_set_height(msg_bubble, LV_SIZE_CONTENT);
-        
-        // Don't grow
-        lv_obj_set_style_flex_grow(msg_bubble, 0, 0);
-    } else if (strcmp(role, "assistant") == 0) {
-        // Assistant messages are left-aligned with white background
-        lv_obj_set_style_bg_color(msg_bubble, current_theme_.assistant_bubble, 0);
-        // Set text color for contrast
-        lv_obj_set_style_text_color(msg_text, current_theme_.text, 0);
-        
-        // 设置自定义属性标记气泡类型
-        lv_obj_set_user_data(msg_bubble, (void*)"assistant");
-        
-        // Set appropriate width for content
-        lv_obj_set_width(msg_bubble, LV_SIZE_CONTENT);
-        lv_obj_set_height(msg_bubble, LV_SIZE_CONTENT);
-        
-        // Don't grow
-        lv_obj_set_style_flex_grow(msg_bubble, 0, 0);
+        lv_obj_set_style_bg_color(slot->bubble, current_theme_.user_bubble, 0);
+        lv_obj_set_style_text_color(slot->label, current_theme_.text, 0);
+        lv_obj_set_user_data(slot->bubble, (void*)"user");
+        lv_obj_align(slot->bubble, LV_ALIGN_RIGHT_MID, -25, 0);
     } else if (strcmp(role, "system") == 0) {
         // System messages are center-aligned with light gray background
-        lv_obj_set_style_bg_color(msg_bubble, current_theme_.system_bubble, 0);
-        // Set text color for contrast
-        lv_obj_set_style_text_color(msg_text, current_theme_.system_text, 0);
-        
-        // 设置自定义属性标记气泡类型
-        lv_obj_set_user_data(msg_bubble, (void*)"system");
-        
-        // Set appropriate width for content
-        lv_obj_set_width(msg_bubble, LV_SIZE_CONTENT);
-        lv_obj_set_height(msg_bubble, LV_SIZE_CONTENT);
-        
-        // Don't grow
-        lv_obj_set_style_flex_grow(msg_bubble, 0, 0);
-    }
-    
-    // Create a full-width container for user messages to ensure right alignment
-    if (strcmp(role, "user") == 0) {
-        // Create a full-width container
-        lv_obj_t* container = lv_obj_create(content_);
-        lv_obj_set_width(container, LV_HOR_RES);
-        lv_obj_set_height(container, LV_SIZE_CONTENT);
-        
-        // Make container transparent and borderless
-        lv_obj_set_style_bg_opa(container, LV_OPA_TRANSP, 0);
-        lv_obj_set_style_border_width(container, 0, 0);
-        lv_obj_set_style_pad_all(container, 0, 0);
-        
-        // Move the message bubble into this container
-        lv_obj_set_parent(msg_bubble, container);
-        
-        // Right align the bubble in the container
-        lv_obj_align(msg_bubble, LV_ALIGN_RIGHT_MID, -25, 0);
-        
-        // Auto-scroll to this container
-        lv_obj_scroll_to_view_recursive(container, LV_ANIM_ON);
-    } else if (strcmp(role, "system") == 0) {
-        // 为系统消息创建全宽容器以确保居中对齐
-        lv_obj_t* container = lv_obj_create(content_);
-        lv_obj_set_width(container, LV_HOR_RES);
-        lv_obj_set_height(container, LV_SIZE_CONTENT);
-        
-        // 使容器透明且无边框
-        lv_obj_set_style_bg_opa(container, LV_OPA_TRANSP, 0);
-        lv_obj_set_style_border_width(container, 0, 0);
-        lv_obj_set_style_pad_all(container, 0, 0);
-        
-        // 将消息气泡移入此容器
-        lv_obj_set_parent(msg_bubble, container);
-        
-        // 将气泡居中对齐在容器中
-        lv_obj_align(msg_bubble, LV_ALIGN_CENTER, 0, 0);
-        
-        // 自动滚动底部
-        lv_obj_scroll_to_view_recursive(container, LV_ANIM_ON);
+        lv_obj_set_style_bg_color(slot->bubble, current_theme_.system_bubble, 0);
+        lv_obj_set_style_text_color(slot->label, current_theme_.system_text, 0);
+        lv_obj_set_user_data(slot->bubble, (void*)"system");
+        lv_obj_align(slot->bubble, LV_ALIGN_CENTER, 0, 0);
     } else {
-        // For assistant messages
-        // Left align assistant messages
-        lv_obj_align(msg_bubble, LV_ALIGN_LEFT_MID, 0, 0);
-
-        // Auto-scroll to the message bubble
-        lv_obj_scroll_to_view_recursive(msg_bubble, LV_ANIM_ON);
+        // Assistant messages are left-aligned with white background
+        lv_obj_set_style_bg_color(slot->bubble, current_theme_.assistant_bubble, 0);
+        lv_obj_set_style_text_color(slot->label, current_theme_.text, 0);
+        lv_obj_set_user_data(slot->bubble, (void*)"assistant");
+        lv_obj_align(slot->bubble, LV_ALIGN_LEFT_MID, 0, 0);
     }
+
+    // Only animate the scroll when the chat is idle, a stream of sentences jumps straight to the bottom
+    lv_obj_scroll_to_view_recursive(slot->row, streaming ? LV_ANIM_OFF : LV_ANIM_ON);
     
     // Store reference to the latest message label
-    chat_message_label_ = msg_text;
+    chat_message_label_ = slot->label;
 }
 
-void LcdDisplay::SetPreviewImage(const lv_img_dsc_t* img_dsc) {
+void LcdDisplay::RenderPreviewImage(std::shared_ptr<PreviewImage> image) {
     DisplayLockGuard lock(this);
     if (content_ == nullptr) {
         return;
     }
     
-    if (img_dsc != nullptr) {
+    if (image != nullptr) {
+        // Keep only the latest few previews, older ones release their image when deleted
+        while (preview_bubbles_.size() >= MAX_PREVIEW_IMAGES) {
+            lv_obj_del(preview_bubbles_.front());
+            preview_bubbles_.pop_front();
+        }
+
         // Create a message bubble for image preview
         lv_obj_t* img_bubble = lv_obj_create(content_);
         lv_obj_set_style_radius(img_bubble, 8, 0);
@@ -625,41 +577,13 @@ void LcdDisplay::SetPreviewImage(const lv_img_dsc_t* img_dsc) {
         // Create the image object inside the bubble
         lv_obj_t* preview_image = lv_image_create(img_bubble);
         
-        // Copy the image descriptor and data to avoid source data changes
-        lv_img_dsc_t* copied_img_dsc = (lv_img_dsc_t*)heap_caps_malloc(sizeof(lv_img_dsc_t), MALLOC_CAP_8BIT);
-        if (copied_img_dsc == nullptr) {
-            ESP_LOGE(TAG, "Failed to allocate memory for image descriptor");
-            lv_obj_del(img_bubble);
-            return;
-        }
-        
-        // Copy the header
-        copied_img_dsc->header = img_dsc->header;
-        copied_img_dsc->data_size = img_dsc->data_size;
-        
-        // Copy the image data
-        uint8_t* copied_data = (uint8_t*)heap_caps_malloc(img_dsc->data_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-        if (copied_data == nullptr) {
-            // Fallback to internal RAM if SPIRAM allocation fails
-            copied_data = (uint8_t*)heap_caps_malloc(img_dsc->data_size, MALLOC_CAP_8BIT);
-        }
-        if (copied_data == nullptr) {
-            ESP_LOGE(TAG, "Failed to allocate memory for image data (size: %lu bytes)", img_dsc->data_size);
-            heap_caps_free(copied_img_dsc);
-            lv_obj_del(img_bubble);
-            return;
-        }
-        
-        memcpy(copied_data, img_dsc->data, img_dsc->data_size);
-        copied_img_dsc->data = copied_data;
-        
         // Calculate appropriate size for the image
         lv_coord_t max_width = LV_HOR_RES * 70 / 100;  // 70% of screen width
         lv_coord_t max_height = LV_VER_RES * 50 / 100; // 50% of screen height
         
         // Calculate zoom factor to fit within maximum dimensions
-        lv_coord_t img_width = copied_img_dsc->header.w;
-        lv_coord_t img_height = copied_img_dsc->header.h;
+        lv_coord_t img_width = image->width();
+        lv_coord_t img_height = image->height();
         
         lv_coord_t zoom_w = (max_width * 256) / img_width;
         lv_coord_t zoom_h = (max_height * 256) / img_height;
@@ -668,18 +592,17 @@ void LcdDisplay::SetPreviewImage(const lv_img_dsc_t* img_dsc) {
         // Ensure zoom doesn't exceed 256 (100%)
         if (zoom > 256) zoom = 256;
         
-        // Set image properties
-        lv_image_set_src(preview_image, copied_img_dsc);
+        // Set image properties, the image data is referenced in place
+        lv_image_set_src(preview_image, image->image());
         lv_image_set_scale(preview_image, zoom);
         
-        // Add event handler to clean up copied data when image is deleted
+        // The bubble holds a reference to the image until it is deleted
         lv_obj_add_event_cb(preview_image, [](lv_event_t* e) {
-            lv_img_dsc_t* copied_img_dsc = (lv_img_dsc_t*)lv_event_get_user_data(e);
-            if (copied_img_dsc != nullptr) {
-                heap_caps_free((void*)copied_img_dsc->data);
-                heap_caps_free(copied_img_dsc);
-            }
-        }, LV_EVENT_DELETE, (void*)copied_img_dsc);
+            auto image = static_cast<std::shared_ptr<PreviewImage>*>(lv_event_get_user_data(e));
+            lv_image_cache_drop((*image)->image());
+            delete image;
+        }, LV_EVENT_DELETE, new std::shared_ptr<PreviewImage>(image));
+        preview_render_start_time_ = image->capture_time();
         
         // Calculate actual scaled image dimensions
         lv_coord_t scaled_width = (img_width * zoom) / 256;
@@ -697,6 +620,8 @@ void LcdDisplay::SetPreviewImage(const lv_img_dsc_t* img_dsc) {
         
         // Left align the image bubble like assistant messages
         lv_obj_align(img_bubble, LV_ALIGN_LEFT_MID, 0, 0);
+        preview_bubbles_.push_back(img_bubble);
+        last_chat_slot_ = nullptr;
 
         // Auto-scroll to the image bubble
         lv_obj_scroll_to_view_recursive(img_bubble, LV_ANIM_ON);
@@ -805,35 +730,49 @@ void LcdDisplay::SetupUI() {
     lv_obj_set_style_text_color(low_battery_label_, lv_color_white(), 0);
     lv_obj_center(low_battery_label_);
     lv_obj_add_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
+
+    AddRenderLatencyCallback();
 }
 
-void LcdDisplay::SetPreviewImage(const lv_img_dsc_t* img_dsc) {
+void LcdDisplay::RenderPreviewImage(std::shared_ptr<PreviewImage> image) {
     DisplayLockGuard lock(this);
     if (preview_image_ == nullptr) {
         return;
     }
     
-    if (img_dsc != nullptr) {
+    if (image != nullptr) {
         // zoom factor 0.5
-        lv_image_set_scale(preview_image_, 128 * width_ / img_dsc->header.w);
-        // 设置图片源并显示预览图片
-        lv_image_set_src(preview_image_, img_dsc);
+        lv_image_set_scale(preview_image_, 128 * width_ / image->width());
+        // 设置图片源并显示预览图片，图片数据直接引用，不再拷贝
+        lv_image_set_src(preview_image_, image->image());
         lv_obj_clear_flag(preview_image_, LV_OBJ_FLAG_HIDDEN);
         // 隐藏emotion_label_
         if (emotion_label_ != nullptr) {
             lv_obj_add_flag(emotion_label_, LV_OBJ_FLAG_HIDDEN);
         }
+        // 释放上一张预览图片，相机可以复用它
+        if (current_preview_ != nullptr) {
+            lv_image_cache_drop(current_preview_->image());
+        }
+        current_preview_ = image;
+        preview_render_start_time_ = image->capture_time();
     } else {
         // 隐藏预览图片并显示emotion_label_
         lv_obj_add_flag(preview_image_, LV_OBJ_FLAG_HIDDEN);
         if (emotion_label_ != nullptr) {
             lv_obj_clear_flag(emotion_label_, LV_OBJ_FLAG_HIDDEN);
         }
+        // 控件不再引用图片数据，释放当前预览图片，相机可以复用它
+        if (current_preview_ != nullptr) {
+            lv_image_set_src(preview_image_, nullptr);
+            lv_image_cache_drop(current_preview_->image());
+            current_preview_.reset();
+        }
     }
 }
 #endif
 
-void LcdDisplay::SetEmotion(const char* emotion) {
+void LcdDisplay::RenderEmotion(const char* emotion) {
     struct Emotion {
         const char* icon;
         const char* text;
@@ -890,7 +829,7 @@ void LcdDisplay::SetEmotion(const char* emotion) {
 #endif
 }
 
-void LcdDisplay::SetIcon(const char* icon) {
+void LcdDisplay::RenderIcon(const char* icon) {
     DisplayLockGuard lock(this);
     if (emotion_label_ == nullptr) {
         return;
@@ -907,7 +846,7 @@ void LcdDisplay::SetIcon(const char* icon) {
 #endif
 }
 
-void LcdDisplay::SetTheme(const std::string& theme_name) {
+void LcdDisplay::RenderTheme(const std::string& theme_name) {
     DisplayLockGuard lock(this);
     
     if (theme_name == "dark" || theme_name == "DARK") {
@@ -1099,5 +1038,5 @@ void LcdDisplay::SetTheme(const std::string& theme_name) {
     }
 
     // No errors occurred. Save theme to settings
-    Display::SetTheme(theme_name);
+    Display::RenderTheme(theme_name);
 }
@@ -8,6 +8,8 @@
 #include <font_emoji.h>
 
 #include <atomic>
+#include <vector>
+#include <deque>
 
 // Theme color structure
 struct ThemeColors {
@@ -34,10 +36,32 @@ protected:
     lv_obj_t* container_ = nullptr;
     lv_obj_t* side_bar_ = nullptr;
     lv_obj_t* preview_image_ = nullptr;
+    int64_t preview_render_start_time_ = 0;
 
     DisplayFonts fonts_;
     ThemeColors current_theme_;
 
+#if CONFIG_USE_WECHAT_MESSAGE_STYLE
+    // Chat bubbles are created once and recycled as a ring, only their text and style change
+    struct ChatSlot {
+        lv_obj_t* row = nullptr;
+        lv_obj_t* bubble = nullptr;
+        lv_obj_t* label = nullptr;
+    };
+    std::vector<ChatSlot> chat_slots_;
+    size_t next_chat_slot_ = 0;
+    ChatSlot* last_chat_slot_ = nullptr;
+    int64_t last_chat_message_time_ = 0;
+    int64_t chat_render_start_time_ = 0;
+    std::deque<lv_obj_t*> preview_bubbles_;
+
+    void CreateChatSlots();
+#else
+    std::shared_ptr<PreviewImage> current_preview_;
+#endif
+
+    void AddRenderLatencyCallback();
+
     void SetupUI();
     virtual bool Lock(int timeout_ms = 0) override;
     virtual void Unlock() override;
@@ -48,15 +72,17 @@ protected:
     
 public:
     ~LcdDisplay();
-    virtual void SetEmotion(const char* emotion) override;
-    virtual void SetIcon(const char* icon) override;
-    virtual void SetPreviewImage(const lv_img_dsc_t* img_dsc) override;
+
+protected:
+    virtual void RenderEmotion(const char* emotion) override;
+    virtual void RenderIcon(const char* icon) override;
+    virtual void RenderPreviewImage(std::shared_ptr<PreviewImage> image) override;
 #if CONFIG_USE_WECHAT_MESSAGE_STYLE
-    virtual void SetChatMessage(const char* role, const char* content) override; 
+    virtual void RenderChatMessage(const char* role, const char* content) override; 
 #endif  
 
     // Add theme switching function
-    virtual void SetTheme(const std::string& theme_name) override;
+    virtual void RenderTheme(const std::string& theme_name) override;
 };
 
 // RGB LCD显示器
@@ -94,7 +94,7 @@ void OledDisplay::Unlock() {
     lvgl_port_unlock();
 }
 
-void OledDisplay::SetChatMessage(const char* role, const char* content) {
+void OledDisplay::RenderChatMessage(const char* role, const char* content) {
     DisplayLockGuard lock(this);
     if (chat_message_label_ == nullptr) {
         return;
@@ -31,7 +31,8 @@ public:
                 DisplayFonts fonts);
     ~OledDisplay();
 
-    virtual void SetChatMessage(const char* role, const char* content) override;
+protected:
+    virtual void RenderChatMessage(const char* role, const char* content) override;
 };
 
 #endif // OLED_DISPLAY_H
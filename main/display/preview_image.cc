@@ -0,0 +1,54 @@
+#include "preview_image.h"
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <cstring>
+
+#define TAG "PreviewImage"
+
+PreviewImage::PreviewImage(int width, int height) {
+    memset(&image_, 0, sizeof(image_));
+    image_.header.magic = LV_IMAGE_HEADER_MAGIC;
+    image_.header.cf = LV_COLOR_FORMAT_RGB565;
+    image_.header.flags = LV_IMAGE_FLAGS_ALLOCATED | LV_IMAGE_FLAGS_MODIFIABLE;
+    image_.header.w = width;
+    image_.header.h = height;
+    image_.header.stride = width * 2;
+
+    size_t size = width * height * 2;
+    image_.data = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    if (image_.data == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate memory for preview image (%dx%d)", width, height);
+        return;
+    }
+    image_.data_size = size;
+}
+
+PreviewImage::~PreviewImage() {
+    if (image_.data != nullptr) {
+        heap_caps_free((void*)image_.data);
+        image_.data = nullptr;
+    }
+}
+
+PreviewImagePool::PreviewImagePool(int width, int height, size_t count)
+    : width_(width), height_(height), images_(count) {
+}
+
+std::shared_ptr<PreviewImage> PreviewImagePool::Acquire() {
+    // Reuse an image nobody else references, only the pool can add references so the count is reliable
+    for (auto& image : images_) {
+        if (image != nullptr && image.use_count() == 1) {
+            return image;
+        }
+    }
+
+    // All images are still on screen, replace the oldest slot; the display keeps its copy alive
+    auto image = std::make_shared<PreviewImage>(width_, height_);
+    if (image->data() == nullptr) {
+        return nullptr;
+    }
+    images_[next_] = image;
+    next_ = (next_ + 1) % images_.size();
+    return image;
+}
@@ -0,0 +1,54 @@
+#ifndef PREVIEW_IMAGE_H
+#define PREVIEW_IMAGE_H
+
+#include <lvgl.h>
+
+#include <memory>
+#include <vector>
+
+// RGB565 image shared between the camera and the display.
+// The camera fills it once and the display keeps a reference while it is on screen,
+// so the frame is never copied in between.
+class PreviewImage {
+public:
+    PreviewImage(int width, int height);
+    ~PreviewImage();
+    PreviewImage(const PreviewImage&) = delete;
+    PreviewImage& operator=(const PreviewImage&) = delete;
+
+    const lv_img_dsc_t* image() const { return &image_; }
+    uint8_t* data() { return (uint8_t*)image_.data; }
+    size_t size() const { return image_.data_size; }
+    int width() const { return image_.header.w; }
+    int height() const { return image_.header.h; }
+
+    // Time the frame was requested from the sensor, used to measure capture-to-preview latency
+    int64_t capture_time() const { return capture_time_; }
+    void set_capture_time(int64_t time) { capture_time_ = time; }
+
+private:
+    lv_img_dsc_t image_;
+    int64_t capture_time_ = 0;
+};
+
+// Number of preview bubbles the display keeps on screen at most
+#define MAX_PREVIEW_IMAGES 2
+
+// A few preview images reused across captures.
+// An image is only overwritten once the display has released it.
+// The display releases old previews only after the new one is captured,
+// so one image more than the display keeps is needed to avoid allocating per capture.
+class PreviewImagePool {
+public:
+    PreviewImagePool(int width, int height, size_t count = MAX_PREVIEW_IMAGES + 1);
+
+    std::shared_ptr<PreviewImage> Acquire();
+
+private:
+    int width_;
+    int height_;
+    size_t next_ = 0;
+    std::vector<std::shared_ptr<PreviewImage>> images_;
+};
+
+#endif // PREVIEW_IMAGE_H
@@ -1,4 +1,5 @@
 #include "thing.h"
+#include "thing_manager.h"
 #include "application.h"
 
 #include <esp_log.h>
@@ -52,40 +53,70 @@ std::string Thing::GetStateJson() {
     return json_str;
 }
 
+bool Thing::GetStateJson(std::string& json, bool delta) {
+    if (!delta) {
+        json = GetStateJson();
+        return true;
+    }
+
+    std::string state = properties_.GetStateJson(true);
+    if (state == "{}") {
+        return false;
+    }
+    json = "{";
+    json += "\"name\":\"" + name_ + "\",";
+    json += "\"state\":" + state;
+    json += "}";
+    return true;
+}
+
+void Thing::NotifyPropertyChanged(const std::string& name) {
+    if (!properties_.MarkDirty(name)) {
+        ESP_LOGW(TAG, "Property not found: %s", name.c_str());
+        return;
+    }
+    ThingManager::GetInstance().MarkStatesDirty();
+}
+
 void Thing::Invoke(const cJSON* command) {
     auto method_name = cJSON_GetObjectItem(command, "method");
     auto input_params = cJSON_GetObjectItem(command, "parameters");
+    if (!cJSON_IsString(method_name)) {
+        ESP_LOGE(TAG, "Missing method for thing: %s", name_.c_str());
+        return;
+    }
 
-    try {
-        auto& method = methods_[method_name->valuestring];
-        for (auto& param : method.parameters()) {
-            auto input_param = cJSON_GetObjectItem(input_params, param.name().c_str());
-            if (param.required() && input_param == nullptr) {
-                throw std::runtime_error("Parameter " + param.name() + " is required");
+    auto method = methods_.Find(method_name->valuestring);
+    if (method == nullptr) {
+        ESP_LOGE(TAG, "Method not found: %s", method_name->valuestring);
+        return;
+    }
+
+    for (auto& param : method->parameters()) {
+        auto input_param = cJSON_GetObjectItem(input_params, param.name().c_str());
+        if (param.required() && input_param == nullptr) {
+            ESP_LOGE(TAG, "Parameter %s is required", param.name().c_str());
+            return;
+        }
+        if (param.type() == kValueTypeNumber) {
+            if (cJSON_IsNumber(input_param)) {
+                param.set_number(input_param->valueint);
             }
-            if (param.type() == kValueTypeNumber) {
-                if (cJSON_IsNumber(input_param)) {
-                    param.set_number(input_param->valueint);
-                }
-            } else if (param.type() == kValueTypeString) {
-                if (cJSON_IsString(input_param) || cJSON_IsObject(input_param) || cJSON_IsArray(input_param)) {
-                    std::string value_str = input_param->valuestring;
-                    param.set_string(value_str);
-                }
-            } else if (param.type() == kValueTypeBoolean) {
-                if (cJSON_IsBool(input_param)) {
-                    param.set_boolean(input_param->valueint == 1);
-                }
+        } else if (param.type() == kValueTypeString) {
+            if (cJSON_IsString(input_param) || cJSON_IsObject(input_param) || cJSON_IsArray(input_param)) {
+                std::string value_str = input_param->valuestring;
+                param.set_string(value_str);
+            }
+        } else if (param.type() == kValueTypeBoolean) {
+            if (cJSON_IsBool(input_param)) {
+                param.set_boolean(input_param->valueint == 1);
             }
         }
-
-        Application::GetInstance().Schedule([&method]() {
-            method.Invoke();
-        });
-    } catch (const std::runtime_error& e) {
-        ESP_LOGE(TAG, "Method not found: %s", method_name->valuestring);
-        return;
     }
+
+    Application::GetInstance().Schedule([method]() {
+        method->Invoke();
+    });
 }
 
 
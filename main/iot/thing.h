@@ -2,8 +2,11 @@
 #define THING_H
 
 #include <string>
+#include <string_view>
 #include <map>
+#include <unordered_map>
 #include <functional>
+#include <variant>
 #include <vector>
 #include <stdexcept>
 #include <cJSON.h>
@@ -16,30 +19,72 @@ enum ValueType {
     kValueTypeString
 };
 
+// How a property finds out that its value has changed
+enum UpdatePolicy {
+    kUpdatePolled,      // The getter is called on every state report and compared with the last value
+    kUpdateOnNotify     // The getter is only called after Thing::NotifyPropertyChanged()
+};
+
 class Property {
 private:
     std::string name_;
     std::string description_;
     ValueType type_;
-    std::function<bool()> boolean_getter_;
-    std::function<int()> number_getter_;
-    std::function<std::string()> string_getter_;
+    UpdatePolicy update_policy_ = kUpdatePolled;
+    // Only one getter is ever used, so keep a single std::function instead of one per type
+    std::variant<std::function<bool()>, std::function<int()>, std::function<std::string()>> getter_;
+
+    // Last reported value, used to build property-level deltas
+    bool reported_ = false;
+    bool dirty_ = true;
+    bool last_boolean_ = false;
+    int last_number_ = 0;
+    std::string last_string_;
 
 public:
-    Property(const std::string& name, const std::string& description, std::function<bool()> getter) :
-        name_(name), description_(description), type_(kValueTypeBoolean), boolean_getter_(getter) {}
-    Property(const std::string& name, const std::string& description, std::function<int()> getter) :
-        name_(name), description_(description), type_(kValueTypeNumber), number_getter_(getter) {}
-    Property(const std::string& name, const std::string& description, std::function<std::string()> getter) :
-        name_(name), description_(description), type_(kValueTypeString), string_getter_(getter) {}
+    Property(const std::string& name, const std::string& description, std::function<bool()> getter, UpdatePolicy policy = kUpdatePolled) :
+        name_(name), description_(description), type_(kValueTypeBoolean), update_policy_(policy), getter_(getter) {}
+    Property(const std::string& name, const std::string& description, std::function<int()> getter, UpdatePolicy policy = kUpdatePolled) :
+        name_(name), description_(description), type_(kValueTypeNumber), update_policy_(policy), getter_(getter) {}
+    Property(const std::string& name, const std::string& description, std::function<std::string()> getter, UpdatePolicy policy = kUpdatePolled) :
+        name_(name), description_(description), type_(kValueTypeString), update_policy_(policy), getter_(getter) {}
 
     const std::string& name() const { return name_; }
     const std::string& description() const { return description_; }
     ValueType type() const { return type_; }
+    UpdatePolicy update_policy() const { return update_policy_; }
+
+    bool boolean() const { return std::get<std::function<bool()>>(getter_)(); }
+    int number() const { return std::get<std::function<int()>>(getter_)(); }
+    std::string string() const { return std::get<std::function<std::string()>>(getter_)(); }
+
+    void MarkDirty() { dirty_ = true; }
+    void ResetReported() { reported_ = false; }
 
-    bool boolean() const { return boolean_getter_(); }
-    int number() const { return number_getter_(); }
-    std::string string() const { return string_getter_(); }
+    // Refresh the cached value from the getter, returns true if it differs from the last reported value
+    bool UpdateState() {
+        if (update_policy_ == kUpdateOnNotify && reported_ && !dirty_) {
+            return false;
+        }
+        dirty_ = false;
+
+        bool changed = !reported_;
+        if (type_ == kValueTypeBoolean) {
+            bool value = boolean();
+            changed = changed || value != last_boolean_;
+            last_boolean_ = value;
+        } else if (type_ == kValueTypeNumber) {
+            int value = number();
+            changed = changed || value != last_number_;
+            last_number_ = value;
+        } else if (type_ == kValueTypeString) {
+            std::string value = string();
+            changed = changed || value != last_string_;
+            last_string_ = std::move(value);
+        }
+        reported_ = true;
+        return changed;
+    }
 
     std::string GetDescriptorJson() {
         std::string json_str = "{";
@@ -55,13 +100,14 @@ public:
         return json_str;
     }
 
+    // Serialize the value cached by the last UpdateState()
     std::string GetStateJson() {
         if (type_ == kValueTypeBoolean) {
-            return boolean_getter_() ? "true" : "false";
+            return last_boolean_ ? "true" : "false";
         } else if (type_ == kValueTypeNumber) {
-            return std::to_string(number_getter_());
+            return std::to_string(last_number_);
         } else if (type_ == kValueTypeString) {
-            return "\"" + string_getter_() + "\"";
+            return "\"" + last_string_ + "\"";
         }
         return "null";
     }
@@ -75,14 +121,14 @@ public:
     PropertyList() = default;
     PropertyList(const std::vector<Property>& properties) : properties_(properties) {}
 
-    void AddBooleanProperty(const std::string& name, const std::string& description, std::function<bool()> getter) {
-        properties_.push_back(Property(name, description, getter));
+    void AddBooleanProperty(const std::string& name, const std::string& description, std::function<bool()> getter, UpdatePolicy policy = kUpdatePolled) {
+        properties_.push_back(Property(name, description, getter, policy));
     }
-    void AddNumberProperty(const std::string& name, const std::string& description, std::function<int()> getter) {
-        properties_.push_back(Property(name, description, getter));
+    void AddNumberProperty(const std::string& name, const std::string& description, std::function<int()> getter, UpdatePolicy policy = kUpdatePolled) {
+        properties_.push_back(Property(name, description, getter, policy));
     }
-    void AddStringProperty(const std::string& name, const std::string& description, std::function<std::string()> getter) {
-        properties_.push_back(Property(name, description, getter));
+    void AddStringProperty(const std::string& name, const std::string& description, std::function<std::string()> getter, UpdatePolicy policy = kUpdatePolled) {
+        properties_.push_back(Property(name, description, getter, policy));
     }
 
     const Property& operator[](const std::string& name) const {
@@ -94,6 +140,25 @@ public:
         throw std::runtime_error("Property not found: " + name);
     }
 
+    bool MarkDirty(const std::string& name) {
+        for (auto& property : properties_) {
+            if (property.name() == name) {
+                property.MarkDirty();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool HasPolledProperties() const {
+        for (auto& property : properties_) {
+            if (property.update_policy() == kUpdatePolled) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     std::string GetDescriptorJson() {
         std::string json_str = "{";
         for (auto& property : properties_) {
@@ -106,9 +171,16 @@ public:
         return json_str;
     }
 
-    std::string GetStateJson() {
+    // With delta, only the properties that changed since the last report are included
+    std::string GetStateJson(bool delta = false) {
         std::string json_str = "{";
         for (auto& property : properties_) {
+            if (!delta) {
+                property.ResetReported();
+            }
+            if (!property.UpdateState() && delta) {
+                continue;
+            }
             json_str += "\"" + property.name() + "\":" + property.GetStateJson() + ",";
         }
         if (json_str.back() == ',') {
@@ -229,22 +301,46 @@ public:
 class MethodList {
 private:
     std::vector<Method> methods_;
+    // Keys point into the names owned by methods_, rebuilt whenever the vector may reallocate
+    std::unordered_map<std::string_view, size_t> index_;
+
+    void RebuildIndex() {
+        index_.clear();
+        for (size_t i = 0; i < methods_.size(); ++i) {
+            index_.emplace(methods_[i].name(), i);
+        }
+    }
 
 public:
     MethodList() = default;
-    MethodList(const std::vector<Method>& methods) : methods_(methods) {}
+    MethodList(const std::vector<Method>& methods) : methods_(methods) {
+        RebuildIndex();
+    }
+    MethodList(const MethodList& other) : methods_(other.methods_) {
+        RebuildIndex();
+    }
+    MethodList& operator=(const MethodList& other) {
+        methods_ = other.methods_;
+        RebuildIndex();
+        return *this;
+    }
 
     void AddMethod(const std::string& name, const std::string& description, const ParameterList& parameters, std::function<void(const ParameterList&)> callback) {
         methods_.push_back(Method(name, description, parameters, callback));
+        RebuildIndex();
+    }
+
+    Method* Find(std::string_view name) {
+        auto it = index_.find(name);
+        return it == index_.end() ? nullptr : &methods_[it->second];
     }
 
     Method& operator[](const std::string& name) {
-        for (auto& method : methods_) {
-            if (method.name() == name) {
-                return method;
-            }
+        auto method = Find(name);
+        if (method == nullptr) {
+            throw std::runtime_error("Method not found: " + name);
         }
-        throw std::runtime_error("Method not found: " + name);
+        return *method;
     }
 
     std::string GetDescriptorJson() {
@@ -270,6 +366,10 @@ public:
     virtual std::string GetStateJson();
     virtual void Invoke(const cJSON* command);
 
+    // Property-level delta, returns false if no property changed since the last report
+    bool GetStateJson(std::string& json, bool delta);
+    bool HasPolledProperties() const { return properties_.HasPolledProperties(); }
+
     const std::string& name() const { return name_; }
     const std::string& description() const { return description_; }
 
@@ -277,6 +377,9 @@ protected:
     PropertyList properties_;
     MethodList methods_;
 
+    // Tell the manager that a kUpdateOnNotify property has a new value
+    void NotifyPropertyChanged(const std::string& name);
+
 private:
     std::string name_;
     std::string description_;
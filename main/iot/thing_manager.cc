@@ -7,10 +7,21 @@
 namespace iot {
 
 void ThingManager::AddThing(Thing* thing) {
+    if (things_by_name_.find(thing->name()) != things_by_name_.end()) {
+        ESP_LOGW(TAG, "Thing %s already added", thing->name().c_str());
+        return;
+    }
     things_.push_back(thing);
+    things_by_name_.emplace(thing->name(), thing);
+    descriptors_json_.clear();
+    has_polled_properties_ = has_polled_properties_ || thing->HasPolledProperties();
+    states_dirty_ = true;
 }
 
 std::string ThingManager::GetDescriptorsJson() {
+    if (!descriptors_json_.empty()) {
+        return descriptors_json_;
+    }
     std::string json_str = "[";
     for (auto& thing : things_) {
         json_str += thing->GetDescriptorJson() + ",";
@@ -19,29 +30,27 @@ std::string ThingManager::GetDescriptorsJson() {
         json_str.pop_back();
     }
     json_str += "]";
-    return json_str;
+    descriptors_json_ = std::move(json_str);
+    return descriptors_json_;
 }
 
 bool ThingManager::GetStatesJson(std::string& json, bool delta) {
-    if (!delta) {
-        last_states_.clear();
+    // 没有被通知的变化，且所有属性都是事件驱动的，直接返回
+    bool dirty = states_dirty_.exchange(false);
+    if (delta && !dirty && !has_polled_properties_) {
+        json = "[]";
+        return false;
     }
+
     bool changed = false;
     json = "[";
-    // 枚举thing，获取每个thing的state，如果发生变化，则更新，保存到last_states_
-    // 如果delta为true，则只返回变化的部分
+    // 枚举thing，delta为true时只返回发生变化的属性
     for (auto& thing : things_) {
-        std::string state = thing->GetStateJson();
-        if (delta) {
-            // 如果delta为true，则只返回变化的部分
-            auto it = last_states_.find(thing->name());
-            if (it != last_states_.end() && it->second == state) {
-                continue;
-            }
+        std::string state;
+        if (thing->GetStateJson(state, delta)) {
             changed = true;
-            last_states_[thing->name()] = state;
+            json += state + ",";
         }
-        json += state + ",";
     }
     if (json.back() == ',') {
         json.pop_back();
@@ -52,12 +61,16 @@ bool ThingManager::GetStatesJson(std::string& json, bool delta) {
 
 void ThingManager::Invoke(const cJSON* command) {
     auto name = cJSON_GetObjectItem(command, "name");
-    for (auto& thing : things_) {
-        if (thing->name() == name->valuestring) {
-            thing->Invoke(command);
-            return;
-        }
+    if (!cJSON_IsString(name)) {
+        ESP_LOGE(TAG, "Missing thing name");
+        return;
+    }
+    auto it = things_by_name_.find(name->valuestring);
+    if (it == things_by_name_.end()) {
+        ESP_LOGW(TAG, "Thing not found: %s", name->valuestring);
+        return;
     }
+    it->second->Invoke(command);
 }
 
 } // namespace iot
@@ -9,7 +9,9 @@
 #include <vector>
 #include <memory>
 #include <functional>
-#include <map>
+#include <atomic>
+#include <string_view>
+#include <unordered_map>
 
 namespace iot {
 
@@ -28,12 +30,20 @@ public:
     bool GetStatesJson(std::string& json, bool delta = false);
     void Invoke(const cJSON* command);
 
+    // Called by things when a kUpdateOnNotify property changes
+    void MarkStatesDirty() { states_dirty_ = true; }
+
 private:
     ThingManager() = default;
     ~ThingManager() = default;
 
     std::vector<Thing*> things_;
-    std::map<std::string, std::string> last_states_;
+    // Keys point into the names owned by the things, which live for the whole program
+    std::unordered_map<std::string_view, Thing*> things_by_name_;
+    // Descriptors never change once the things are registered, so they are generated only once
+    std::string descriptors_json_;
+    std::atomic<bool> states_dirty_{true};
+    bool has_polled_properties_ = false;
 };
 
 
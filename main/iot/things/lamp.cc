@@ -38,17 +38,19 @@ public:
         // 定义设备的属性
         properties_.AddBooleanProperty("power", "Whether the lamp is on", [this]() -> bool {
             return power_;
-        });
+        }, kUpdateOnNotify);
 
         // 定义设备可以被远程执行的指令
         methods_.AddMethod("turn_on", "Turn on the lamp", ParameterList(), [this](const ParameterList& parameters) {
             power_ = true;
             gpio_set_level(gpio_num_, 1);
+            NotifyPropertyChanged("power");
         });
 
         methods_.AddMethod("turn_off", "Turn off the lamp", ParameterList(), [this](const ParameterList& parameters) {
             power_ = false;
             gpio_set_level(gpio_num_, 0);
+            NotifyPropertyChanged("power");
         });
     }
 };
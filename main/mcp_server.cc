@@ -17,6 +17,19 @@
 #define TAG "MCP"
 
 #define DEFAULT_TOOLCALL_STACK_SIZE 6144
+#define MAX_BATCH_SIZE 16
+
+// Progress token of the tool call running on the current thread, used by NotifyProgress
+static thread_local const std::string* current_progress_token = nullptr;
+
+static std::string JoinBatchReplies(const std::vector<std::string>& replies) {
+    std::string payload = "[";
+    for (auto& reply : replies) {
+        payload += reply + ",";
+    }
+    payload.back() = ']';
+    return payload;
+}
 
 McpServer::McpServer() {
 }
@@ -56,6 +69,47 @@ void McpServer::AddCommonTools() {
             codec->SetOutputVolume(properties["volume"].value<int>());
             return true;
         });
+
+    AddTool("self.audio_speaker.set_buffer_mode",
+        "Set the audio buffer mode, takes effect after the device restarts.\n"
+        "Args:\n"
+        "  `mode`: `low_latency` for realtime conversation and fast interruption, `robust` for smooth long playback, `balanced`,\n"
+        "  or `auto` to go back to the buffer mode the firmware was built with.\n"
+        "Return:\n"
+        "  The DMA depth and the output latency after restart.",
+        PropertyList({
+            Property("mode", kPropertyTypeString)
+        }),
+        [&board](const PropertyList& properties) -> ReturnValue {
+            auto mode = properties["mode"].value<std::string>();
+            int desc_num, frame_num;
+            if (mode == "low_latency") {
+                desc_num = 4;
+                frame_num = 160;
+            } else if (mode == "robust") {
+                desc_num = 8;
+                frame_num = 480;
+            } else if (mode == "balanced") {
+                desc_num = 6;
+                frame_num = 240;
+            } else if (mode == "auto") {
+                desc_num = AUDIO_CODEC_DMA_DESC_NUM;
+                frame_num = AUDIO_CODEC_DMA_FRAME_NUM;
+            } else {
+                throw std::runtime_error("Invalid mode: " + mode);
+            }
+            auto codec = board.GetAudioCodec();
+            if (mode == "auto") {
+                codec->ResetDmaDepth();
+            } else {
+                codec->SetDmaDepth(desc_num, frame_num);
+            }
+            int latency_ms = desc_num * frame_num * 1000 / codec->output_sample_rate();
+            return "{\"success\": true, \"dma_desc_num\": " + std::to_string(desc_num) +
+                ", \"dma_frame_num\": " + std::to_string(frame_num) +
+                ", \"output_latency_ms\": " + std::to_string(latency_ms) +
+                ", \"current_output_latency_ms\": " + std::to_string(codec->output_latency_ms()) + "}";
+        });
     
     // ==================== 新增区域开始：添加会议记录工具 ====================
     AddTool("self.meeting_recorder.start",
@@ -113,10 +167,12 @@ void McpServer::AddCommonTools() {
             PropertyList({
                 Property("question", kPropertyTypeString)
             }),
-            [camera](const PropertyList& properties) -> ReturnValue {
+            [this, camera](const PropertyList& properties) -> ReturnValue {
+                NotifyProgress(0, 2, "Capturing photo");
                 if (!camera->Capture()) {
                     return "{\"success\": false, \"message\": \"Failed to capture photo\"}";
                 }
+                NotifyProgress(1, 2, "Explaining photo");
                 auto question = properties["question"].value<std::string>();
                 return camera->Explain(question);
             });
@@ -171,6 +227,51 @@ void McpServer::ParseCapabilities(const cJSON* capabilities) {
 }
 
 void McpServer::ParseMessage(const cJSON* json) {
+    if (cJSON_IsArray(json)) {
+        ParseBatch(json);
+        return;
+    }
+
+    std::string reply;
+    std::vector<McpToolCall> tool_calls;
+    ParseRequest(json, reply, tool_calls);
+    if (!tool_calls.empty()) {
+        RunToolCalls(std::move(tool_calls), {}, false);
+    } else if (!reply.empty()) {
+        Application::GetInstance().SendMcpMessage(reply);
+    }
+}
+
+// JSON-RPC 2.0 batch: all requests are parsed up front, tool calls run in order on a single
+// tool call thread, and every response is sent back as one array in a single message.
+void McpServer::ParseBatch(const cJSON* json) {
+    int size = cJSON_GetArraySize(json);
+    if (size == 0) {
+        ESP_LOGE(TAG, "Empty batch");
+        Application::GetInstance().SendMcpMessage("{\"jsonrpc\":\"2.0\",\"id\":null,\"error\":{\"message\":\"Invalid Request\"}}");
+        return;
+    }
+    if (size > MAX_BATCH_SIZE) {
+        ESP_LOGE(TAG, "Batch too large: %d", size);
+        Application::GetInstance().SendMcpMessage("{\"jsonrpc\":\"2.0\",\"id\":null,\"error\":{\"message\":\"Batch too large\"}}");
+        return;
+    }
+
+    std::vector<std::string> replies;
+    std::vector<McpToolCall> tool_calls;
+    const cJSON* item;
+    cJSON_ArrayForEach(item, json) {
+        std::string reply;
+        ParseRequest(item, reply, tool_calls);
+        if (!reply.empty()) {
+            replies.push_back(std::move(reply));
+        }
+    }
+    ESP_LOGI(TAG, "Batch of %d requests, %d tool calls", size, (int)tool_calls.size());
+    RunToolCalls(std::move(tool_calls), std::move(replies), true);
+}
+
+void McpServer::ParseRequest(const cJSON* json, std::string& reply, std::vector<McpToolCall>& tool_calls) {
     // Check JSONRPC version
     auto version = cJSON_GetObjectItem(json, "jsonrpc");
     if (version == nullptr || !cJSON_IsString(version) || strcmp(version->valuestring, "2.0") != 0) {
@@ -215,7 +316,7 @@ void McpServer::ParseMessage(const cJSON* json) {
         std::string message = "{\"protocolVersion\":\"2024-11-05\",\"capabilities\":{\"tools\":{}},\"serverInfo\":{\"name\":\"" BOARD_NAME "\",\"version\":\"";
         message += app_desc->version;
         message += "\"}}";
-        ReplyResult(id_int, message);
+        reply = MakeResult(id_int, message);
     } else if (method_str == "tools/list") {
         std::string cursor_str = "";
         if (params != nullptr) {
@@ -224,56 +325,94 @@ void McpServer::ParseMessage(const cJSON* json) {
                 cursor_str = std::string(cursor->valuestring);
             }
         }
-        GetToolsList(id_int, cursor_str);
+        reply = GetToolsList(id_int, cursor_str);
     } else if (method_str == "tools/call") {
         if (!cJSON_IsObject(params)) {
             ESP_LOGE(TAG, "tools/call: Missing params");
-            ReplyError(id_int, "Missing params");
+            reply = MakeError(id_int, "Missing params");
             return;
         }
         auto tool_name = cJSON_GetObjectItem(params, "name");
         if (!cJSON_IsString(tool_name)) {
             ESP_LOGE(TAG, "tools/call: Missing name");
-            ReplyError(id_int, "Missing name");
+            reply = MakeError(id_int, "Missing name");
             return;
         }
         auto tool_arguments = cJSON_GetObjectItem(params, "arguments");
         if (tool_arguments != nullptr && !cJSON_IsObject(tool_arguments)) {
             ESP_LOGE(TAG, "tools/call: Invalid arguments");
-            ReplyError(id_int, "Invalid arguments");
+            reply = MakeError(id_int, "Invalid arguments");
             return;
         }
         auto stack_size = cJSON_GetObjectItem(params, "stackSize");
         if (stack_size != nullptr && !cJSON_IsNumber(stack_size)) {
             ESP_LOGE(TAG, "tools/call: Invalid stackSize");
-            ReplyError(id_int, "Invalid stackSize");
+            reply = MakeError(id_int, "Invalid stackSize");
             return;
         }
-        DoToolCall(id_int, std::string(tool_name->valuestring), tool_arguments, stack_size ? stack_size->valueint : DEFAULT_TOOLCALL_STACK_SIZE);
+
+        McpToolCall call;
+        call.stack_size = stack_size ? stack_size->valueint : DEFAULT_TOOLCALL_STACK_SIZE;
+        auto meta = cJSON_GetObjectItem(params, "_meta");
+        if (cJSON_IsObject(meta)) {
+            auto progress_token = cJSON_GetObjectItem(meta, "progressToken");
+            if (cJSON_IsString(progress_token) || cJSON_IsNumber(progress_token)) {
+                char* token_str = cJSON_PrintUnformatted(progress_token);
+                call.progress_token = token_str;
+                cJSON_free(token_str);
+            }
+        }
+        if (!PrepareToolCall(id_int, std::string(tool_name->valuestring), tool_arguments, call, reply)) {
+            return;
+        }
+        tool_calls.push_back(std::move(call));
     } else {
         ESP_LOGE(TAG, "Method not implemented: %s", method_str.c_str());
-        ReplyError(id_int, "Method not implemented: " + method_str);
+        reply = MakeError(id_int, "Method not implemented: " + method_str);
     }
 }
 
-void McpServer::ReplyResult(int id, const std::string& result) {
+std::string McpServer::MakeResult(int id, const std::string& result) {
     std::string payload = "{\"jsonrpc\":\"2.0\",\"id\":";
     payload += std::to_string(id) + ",\"result\":";
     payload += result;
     payload += "}";
-    Application::GetInstance().SendMcpMessage(payload);
+    return payload;
 }
 
-void McpServer::ReplyError(int id, const std::string& message) {
+std::string McpServer::MakeError(int id, const std::string& message) {
     std::string payload = "{\"jsonrpc\":\"2.0\",\"id\":";
     payload += std::to_string(id);
     payload += ",\"error\":{\"message\":\"";
     payload += message;
     payload += "\"}}";
+    return payload;
+}
+
+void McpServer::NotifyProgress(int progress, int total, const std::string& message) {
+    if (current_progress_token == nullptr || current_progress_token->empty()) {
+        return;
+    }
+
+    cJSON* params = cJSON_CreateObject();
+    cJSON_AddItemToObject(params, "progressToken", cJSON_Parse(current_progress_token->c_str()));
+    cJSON_AddNumberToObject(params, "progress", progress);
+    if (total > 0) {
+        cJSON_AddNumberToObject(params, "total", total);
+    }
+    if (!message.empty()) {
+        cJSON_AddStringToObject(params, "message", message.c_str());
+    }
+    char* params_str = cJSON_PrintUnformatted(params);
+    std::string payload = "{\"jsonrpc\":\"2.0\",\"method\":\"notifications/progress\",\"params\":";
+    payload += params_str;
+    payload += "}";
+    cJSON_free(params_str);
+    cJSON_Delete(params);
     Application::GetInstance().SendMcpMessage(payload);
 }
 
-void McpServer::GetToolsList(int id, const std::string& cursor) {
+std::string McpServer::GetToolsList(int id, const std::string& cursor) {
     const int max_payload_size = 8000;
     std::string json = "{\"tools\":[";
     
@@ -311,8 +450,7 @@ void McpServer::GetToolsList(int id, const std::string& cursor) {
     if (json.back() == '[' && !tools_.empty()) {
         // 如果没有添加任何tool，返回错误
         ESP_LOGE(TAG, "tools/list: Failed to add tool %s because of payload size limit", next_cursor.c_str());
-        ReplyError(id, "Failed to add tool " + next_cursor + " because of payload size limit");
-        return;
+        return MakeError(id, "Failed to add tool " + next_cursor + " because of payload size limit");
     }
 
     if (next_cursor.empty()) {
@@ -321,10 +459,10 @@ void McpServer::GetToolsList(int id, const std::string& cursor) {
         json += "],\"nextCursor\":\"" + next_cursor + "\"}";
     }
     
-    ReplyResult(id, json);
+    return MakeResult(id, json);
 }
 
-void McpServer::DoToolCall(int id, const std::string& tool_name, const cJSON* tool_arguments, int stack_size) {
+bool McpServer::PrepareToolCall(int id, const std::string& tool_name, const cJSON* tool_arguments, McpToolCall& call, std::string& error) {
     auto tool_iter = std::find_if(tools_.begin(), tools_.end(), 
                                  [&tool_name](const McpTool* tool) { 
                                      return tool->name() == tool_name; 
@@ -332,8 +470,8 @@ void McpServer::DoToolCall(int id, const std::string& tool_name, const cJSON* to
     
     if (tool_iter == tools_.end()) {
         ESP_LOGE(TAG, "tools/call: Unknown tool: %s", tool_name.c_str());
-        ReplyError(id, "Unknown tool: " + tool_name);
-        return;
+        error = MakeError(id, "Unknown tool: " + tool_name);
+        return false;
     }
 
     PropertyList arguments = (*tool_iter)->properties();
@@ -356,16 +494,37 @@ void McpServer::DoToolCall(int id, const std::string& tool_name, const cJSON* to
 
             if (!argument.has_default_value() && !found) {
                 ESP_LOGE(TAG, "tools/call: Missing valid argument: %s", argument.name().c_str());
-                ReplyError(id, "Missing valid argument: " + argument.name());
-                return;
+                error = MakeError(id, "Missing valid argument: " + argument.name());
+                return false;
             }
         }
     } catch (const std::exception& e) {
         ESP_LOGE(TAG, "tools/call: %s", e.what());
-        ReplyError(id, e.what());
+        error = MakeError(id, e.what());
+        return false;
+    }
+
+    call.id = id;
+    call.tool = *tool_iter;
+    call.arguments = std::move(arguments);
+    return true;
+}
+
+void McpServer::RunToolCalls(std::vector<McpToolCall>&& tool_calls, std::vector<std::string>&& replies, bool batch) {
+    if (tool_calls.empty()) {
+        // Nothing to execute, the batch only contained immediate replies (or notifications)
+        if (!replies.empty()) {
+            Application::GetInstance().SendMcpMessage(JoinBatchReplies(replies));
+        }
         return;
     }
 
+    // A batch runs on one thread, so give it the largest stack any of its tools asked for
+    int stack_size = 0;
+    for (auto& call : tool_calls) {
+        stack_size = std::max(stack_size, call.stack_size);
+    }
+
     // Start a task to receive data with stack size
     esp_pthread_cfg_t cfg = esp_pthread_get_default_config();
     cfg.thread_name = "tool_call";
@@ -374,13 +533,19 @@ void McpServer::DoToolCall(int id, const std::string& tool_name, const cJSON* to
     esp_pthread_set_cfg(&cfg);
 
     // Use a thread to call the tool to avoid blocking the main thread
-    tool_call_thread_ = std::thread([this, id, tool_iter, arguments = std::move(arguments)]() {
-        try {
-            ReplyResult(id, (*tool_iter)->Call(arguments));
-        } catch (const std::exception& e) {
-            ESP_LOGE(TAG, "tools/call: %s", e.what());
-            ReplyError(id, e.what());
+    tool_call_thread_ = std::thread([this, batch, tool_calls = std::move(tool_calls), replies = std::move(replies)]() mutable {
+        for (auto& call : tool_calls) {
+            current_progress_token = &call.progress_token;
+            try {
+                replies.push_back(MakeResult(call.id, call.tool->Call(call.arguments)));
+            } catch (const std::exception& e) {
+                ESP_LOGE(TAG, "tools/call: %s", e.what());
+                replies.push_back(MakeError(call.id, e.what()));
+            }
+            current_progress_token = nullptr;
         }
+
+        Application::GetInstance().SendMcpMessage(batch ? JoinBatchReplies(replies) : replies.front());
     });
     tool_call_thread_.detach();
-}
\ No newline at end of file
+}
@@ -249,6 +249,15 @@ public:
     }
 };
 
+// A validated tools/call request waiting to be executed on the tool call thread
+struct McpToolCall {
+    int id;
+    McpTool* tool;
+    PropertyList arguments;
+    int stack_size;
+    std::string progress_token; // Serialized JSON value of params._meta.progressToken, empty if absent
+};
+
 class McpServer {
 public:
     static McpServer& GetInstance() {
@@ -261,6 +270,8 @@ public:
     void AddTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback);
     void ParseMessage(const cJSON* json);
     void ParseMessage(const std::string& message);
+    // Send notifications/progress for the tool call running on the current thread
+    void NotifyProgress(int progress, int total, const std::string& message = "");
 
 private:
     McpServer();
@@ -268,11 +279,15 @@ private:
 
     void ParseCapabilities(const cJSON* capabilities);
 
-    void ReplyResult(int id, const std::string& result);
-    void ReplyError(int id, const std::string& message);
+    void ParseRequest(const cJSON* json, std::string& reply, std::vector<McpToolCall>& tool_calls);
+    void ParseBatch(const cJSON* json);
+
+    std::string MakeResult(int id, const std::string& result);
+    std::string MakeError(int id, const std::string& message);
 
-    void GetToolsList(int id, const std::string& cursor);
-    void DoToolCall(int id, const std::string& tool_name, const cJSON* tool_arguments, int stack_size);
+    std::string GetToolsList(int id, const std::string& cursor);
+    bool PrepareToolCall(int id, const std::string& tool_name, const cJSON* tool_arguments, McpToolCall& call, std::string& error);
+    void RunToolCalls(std::vector<McpToolCall>&& tool_calls, std::vector<std::string>&& replies, bool batch);
 
     std::vector<McpTool*> tools_;
     std::thread tool_call_thread_;
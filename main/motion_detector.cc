@@ -0,0 +1,101 @@
+#include "motion_detector.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+// 背景每帧向当前画面靠近 1/8，用于适应缓慢的光线变化
+#define BACKGROUND_SHIFT 3
+
+MotionDetector::MotionDetector(int width, int height)
+    : width_(width), height_(height), roi_width_(width), roi_height_(height), background_(width * height) {
+}
+
+void MotionDetector::SetRoi(int x, int y, int width, int height) {
+    roi_x_ = std::clamp(x, 0, width_ - 1);
+    roi_y_ = std::clamp(y, 0, height_ - 1);
+    roi_width_ = std::clamp(width, 1, width_ - roi_x_);
+    roi_height_ = std::clamp(height, 1, height_ - roi_y_);
+    Reset();
+}
+
+void MotionDetector::SetThreshold(int pixel_threshold, int area_percent) {
+    pixel_threshold_ = pixel_threshold;
+    area_percent_ = area_percent;
+}
+
+void MotionDetector::SetMinConsecutive(int frames) {
+    min_consecutive_ = std::max(frames, 1);
+}
+
+void MotionDetector::SetCooldown(int frames) {
+    cooldown_frames_ = std::max(frames, 0);
+    cooldown_left_ = cooldown_frames_;
+}
+
+void MotionDetector::Reset() {
+    has_background_ = false;
+    consecutive_ = 0;
+    changed_percent_ = 0;
+    cooldown_left_ = cooldown_frames_;
+}
+
+bool MotionDetector::Feed(const uint8_t* luma) {
+    bool cooling_down = cooldown_left_ > 0;
+    if (cooling_down) {
+        cooldown_left_--;
+    }
+
+    if (!has_background_) {
+        for (int y = roi_y_; y < roi_y_ + roi_height_; y++) {
+            for (int x = roi_x_; x < roi_x_ + roi_width_; x++) {
+                background_[y * width_ + x] = luma[y * width_ + x] << 4;
+            }
+        }
+        has_background_ = true;
+        return false;
+    }
+
+    // 先求整体亮度的偏移，自动曝光或开灯造成的整体变化不算运动
+    int64_t sum = 0;
+    for (int y = roi_y_; y < roi_y_ + roi_height_; y++) {
+        const uint8_t* row = luma + y * width_;
+        const int16_t* bg = background_.data() + y * width_;
+        for (int x = roi_x_; x < roi_x_ + roi_width_; x++) {
+            sum += (row[x] << 4) - bg[x];
+        }
+    }
+    int pixels = roi_width_ * roi_height_;
+    int offset = sum / pixels;
+
+    // 局部的大面积变化也会拉高偏移，所以同时统计补偿前后的变化像素，取较小值
+    int changed = 0;
+    int changed_compensated = 0;
+    int threshold = pixel_threshold_ << 4;
+    for (int y = roi_y_; y < roi_y_ + roi_height_; y++) {
+        const uint8_t* row = luma + y * width_;
+        int16_t* bg = background_.data() + y * width_;
+        for (int x = roi_x_; x < roi_x_ + roi_width_; x++) {
+            int diff = (row[x] << 4) - bg[x];
+            if (abs(diff) > threshold) {
+                changed++;
+            }
+            if (abs(diff - offset) > threshold) {
+                changed_compensated++;
+            }
+            bg[x] += diff >> BACKGROUND_SHIFT;
+        }
+    }
+
+    changed_percent_ = std::min(changed, changed_compensated) * 100 / pixels;
+    // 冷却期间仍然更新背景，让背景跟上当前场景
+    if (changed_percent_ >= area_percent_ && !cooling_down) {
+        consecutive_++;
+    } else {
+        consecutive_ = 0;
+    }
+    if (consecutive_ >= min_consecutive_) {
+        consecutive_ = 0;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,53 @@
+#ifndef MOTION_DETECTOR_H
+#define MOTION_DETECTOR_H
+
+#include <cstdint>
+#include <vector>
+
+// 基于帧差的画面变化检测，输入为低分辨率的 8 位亮度图。
+// 只依赖标准库，可以在 PC 上用录制的帧测试与评估性能。
+class MotionDetector {
+public:
+    MotionDetector(int width, int height);
+
+    // ROI 使用亮度图坐标，默认为整幅画面
+    void SetRoi(int x, int y, int width, int height);
+    // pixel_threshold: 单个像素与背景的亮度差阈值
+    // area_percent: ROI 内变化像素的占比达到该值才算这一帧有变化
+    void SetThreshold(int pixel_threshold, int area_percent);
+    // 连续多少个处理帧有变化才认为检测到运动，用于过滤噪声与闪烁
+    void SetMinConsecutive(int frames);
+    // Reset 之后的若干个输入帧内只更新背景，不报告运动，让自动曝光稳定
+    void SetCooldown(int frames);
+
+    // 输入一帧亮度图（width * height 字节），检测到运动时返回 true
+    bool Feed(const uint8_t* luma);
+    // 丢弃背景，下一帧重新建立背景，并重新开始冷却
+    void Reset();
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    // 最近一个处理帧中 ROI 内变化像素的占比
+    int changed_percent() const { return changed_percent_; }
+
+private:
+    int width_;
+    int height_;
+    int roi_x_ = 0;
+    int roi_y_ = 0;
+    int roi_width_;
+    int roi_height_;
+    int pixel_threshold_ = 20;
+    int area_percent_ = 10;
+    int min_consecutive_ = 2;
+    int cooldown_frames_ = 0;
+
+    // 背景为亮度的滑动平均，4 位小数的定点数
+    std::vector<int16_t> background_;
+    bool has_background_ = false;
+    int consecutive_ = 0;
+    int cooldown_left_ = 0;
+    int changed_percent_ = 0;
+};
+
+#endif // MOTION_DETECTOR_H
@@ -0,0 +1,75 @@
+#include "motion_wake.h"
+
+#include <esp_log.h>
+
+#define TAG "MotionWake"
+
+#define MOTION_RUN_EVENT (1 << 0)
+#define MOTION_RESET_EVENT (1 << 1)
+
+#define LUMA_WIDTH 64
+#define LUMA_HEIGHT 48
+// 回到空闲后先等待一段时间，让自动曝光稳定，也避免对话刚结束就再次触发
+#define MOTION_WAKE_COOLDOWN_MS 30000
+
+MotionWake::MotionWake(Camera* camera)
+    : camera_(camera), detector_(LUMA_WIDTH, LUMA_HEIGHT), luma_(LUMA_WIDTH * LUMA_HEIGHT) {
+    detector_.SetRoi(CONFIG_MOTION_WAKE_ROI_X * LUMA_WIDTH / 100, CONFIG_MOTION_WAKE_ROI_Y * LUMA_HEIGHT / 100,
+        CONFIG_MOTION_WAKE_ROI_WIDTH * LUMA_WIDTH / 100, CONFIG_MOTION_WAKE_ROI_HEIGHT * LUMA_HEIGHT / 100);
+    detector_.SetThreshold(CONFIG_MOTION_WAKE_PIXEL_THRESHOLD, CONFIG_MOTION_WAKE_AREA_PERCENT);
+    detector_.SetCooldown(MOTION_WAKE_COOLDOWN_MS * CONFIG_MOTION_WAKE_FPS / 1000);
+
+    event_group_ = xEventGroupCreate();
+    xTaskCreate([](void* arg) {
+        auto motion_wake = (MotionWake*)arg;
+        motion_wake->DetectLoop();
+        vTaskDelete(NULL);
+    }, "motion_wake", 4096, this, 1, &task_handle_);
+}
+
+MotionWake::~MotionWake() {
+    if (task_handle_ != nullptr) {
+        vTaskDelete(task_handle_);
+    }
+    if (event_group_ != nullptr) {
+        vEventGroupDelete(event_group_);
+    }
+}
+
+void MotionWake::OnMotionDetected(std::function<void(int changed_percent)> callback) {
+    on_motion_detected_ = callback;
+}
+
+void MotionWake::Start() {
+    xEventGroupSetBits(event_group_, MOTION_RUN_EVENT | MOTION_RESET_EVENT);
+}
+
+void MotionWake::Stop() {
+    xEventGroupClearBits(event_group_, MOTION_RUN_EVENT);
+}
+
+void MotionWake::DetectLoop() {
+    while (true) {
+        xEventGroupWaitBits(event_group_, MOTION_RUN_EVENT, pdFALSE, pdTRUE, portMAX_DELAY);
+        auto bits = xEventGroupClearBits(event_group_, MOTION_RESET_EVENT);
+        if (bits & MOTION_RESET_EVENT) {
+            detector_.Reset();
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(1000 / CONFIG_MOTION_WAKE_FPS));
+        if (!(xEventGroupGetBits(event_group_) & MOTION_RUN_EVENT)) {
+            continue;
+        }
+        if (!camera_->CaptureStreamFrame(luma_.data(), LUMA_WIDTH, LUMA_HEIGHT)) {
+            continue;
+        }
+
+        if (!detector_.Feed(luma_.data())) {
+            continue;
+        }
+        ESP_LOGI(TAG, "Motion detected, %d%% of the region changed", detector_.changed_percent());
+        if (on_motion_detected_) {
+            on_motion_detected_(detector_.changed_percent());
+        }
+    }
+}
@@ -0,0 +1,35 @@
+#ifndef MOTION_WAKE_H
+#define MOTION_WAKE_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+#include <freertos/task.h>
+
+#include <functional>
+#include <vector>
+
+#include "camera.h"
+#include "motion_detector.h"
+
+// 空闲时以较低帧率从摄像头取亮度图，检测到画面变化时像唤醒词一样触发对话
+class MotionWake {
+public:
+    MotionWake(Camera* camera);
+    ~MotionWake();
+
+    void OnMotionDetected(std::function<void(int changed_percent)> callback);
+    void Start();
+    void Stop();
+
+private:
+    Camera* camera_;
+    MotionDetector detector_;
+    std::vector<uint8_t> luma_;
+    TaskHandle_t task_handle_ = nullptr;
+    EventGroupHandle_t event_group_ = nullptr;
+    std::function<void(int changed_percent)> on_motion_detected_;
+
+    void DetectLoop();
+};
+
+#endif // MOTION_WAKE_H
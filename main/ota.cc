@@ -1,13 +1,17 @@
 #include "ota.h"
 #include "system_info.h"
 #include "settings.h"
+#include "ota_package.h"
 #include "assets/lang_config.h"
 
 #include <cJSON.h>
 #include <esp_log.h>
+#include <esp_heap_caps.h>
 #include <esp_partition.h>
 #include <esp_ota_ops.h>
 #include <esp_app_format.h>
+#include <esp_timer.h>
+#include <mbedtls/sha256.h>
 #include <esp_efuse.h>
 #include <esp_efuse_table.h>
 #ifdef SOC_HMAC_SUPPORTED
@@ -15,12 +19,265 @@
 #endif
 
 #include <cstring>
+#include <strings.h>
 #include <vector>
 #include <sstream>
 #include <algorithm>
+#include <atomic>
+#include <memory>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
 
 #define TAG "Ota"
 
+// 下载缓冲区优先放在 PSRAM，没有 PSRAM 的板子使用较小的内部 RAM 缓冲区
+// 缓冲区大小需要是 Flash 扇区大小的整数倍，断点只记录在扇区边界上
+#define OTA_BUFFER_SIZE (32 * 1024)
+#define OTA_BUFFER_SIZE_INTERNAL (4 * 1024)
+#define OTA_BUFFER_COUNT 2
+#define OTA_SECTOR_SIZE 4096
+// 每写入这么多数据保存一次断点，避免频繁写 NVS
+#define OTA_CHECKPOINT_INTERVAL (128 * 1024)
+#define OTA_MAX_RETRIES 5
+#define OTA_RETRY_DELAY_MS 2000
+// 升级包的网络读取缓冲区，解码后的数据再复制到写入缓冲区
+#define OTA_PACKAGE_INPUT_SIZE 4096
+
+static std::string ToHexString(const uint8_t* data, size_t length) {
+    static const char hex[] = "0123456789abcdef";
+    std::string result;
+    result.reserve(length * 2);
+    for (size_t i = 0; i < length; i++) {
+        result.push_back(hex[data[i] >> 4]);
+        result.push_back(hex[data[i] & 0x0F]);
+    }
+    return result;
+}
+
+// 下载与写 Flash 的流水线：网络读取填满一块缓冲区后交给写入任务，
+// 写入任务擦写 Flash 的同时网络继续读取下一块。
+// 直接按分区偏移擦写，而不是 esp_ota_begin/esp_ota_write，这样才能从断点继续写入同一个分区，
+// 镜像的校验由 esp_ota_set_boot_partition 完成
+class OtaFlashWriter {
+public:
+    struct Buffer {
+        uint8_t* data;
+        size_t length;
+    };
+
+    OtaFlashWriter() {
+        mbedtls_sha256_init(&sha256_);
+        buffer_size_ = OTA_BUFFER_SIZE;
+        buffers_ = (uint8_t*)heap_caps_malloc(buffer_size_ * OTA_BUFFER_COUNT, MALLOC_CAP_SPIRAM);
+        if (buffers_ == nullptr) {
+            buffer_size_ = OTA_BUFFER_SIZE_INTERNAL;
+            buffers_ = (uint8_t*)heap_caps_malloc(buffer_size_ * OTA_BUFFER_COUNT, MALLOC_CAP_8BIT);
+        }
+        free_buffers_ = xQueueCreate(OTA_BUFFER_COUNT, sizeof(Buffer));
+        filled_buffers_ = xQueueCreate(OTA_BUFFER_COUNT + 1, sizeof(Buffer));
+        done_ = xSemaphoreCreateBinary();
+        if (buffers_ == nullptr || free_buffers_ == nullptr || filled_buffers_ == nullptr || done_ == nullptr) {
+            ESP_LOGE(TAG, "Failed to allocate OTA buffers");
+            return;
+        }
+        for (int i = 0; i < OTA_BUFFER_COUNT; i++) {
+            Buffer buffer = {
+                .data = buffers_ + i * buffer_size_,
+                .length = 0
+            };
+            xQueueSend(free_buffers_, &buffer, 0);
+        }
+    }
+
+    ~OtaFlashWriter() {
+        if (running_) {
+            Stop();
+        }
+        mbedtls_sha256_free(&sha256_);
+        if (done_) {
+            vSemaphoreDelete(done_);
+        }
+        if (filled_buffers_) {
+            vQueueDelete(filled_buffers_);
+        }
+        if (free_buffers_) {
+            vQueueDelete(free_buffers_);
+        }
+        if (buffers_) {
+            heap_caps_free(buffers_);
+        }
+    }
+
+    bool IsValid() const { return buffers_ != nullptr && free_buffers_ != nullptr && filled_buffers_ != nullptr && done_ != nullptr; }
+    bool started() const { return running_; }
+    size_t buffer_size() const { return buffer_size_; }
+    size_t written() const { return written_; }
+
+    // 每写到一个断点时调用，参数为已写入的字节数和这部分数据的 SHA-256
+    void OnCheckpoint(std::function<void(size_t offset, const std::string& sha256)> callback) {
+        on_checkpoint_ = callback;
+    }
+
+    // 从 offset 处开始写入。offset 大于 0 时，分区中已有的数据必须与 prefix_sha256 一致
+    bool Begin(const esp_partition_t* partition, size_t offset, const std::string& prefix_sha256 = "") {
+        if (offset % OTA_SECTOR_SIZE != 0 || offset >= partition->size) {
+            ESP_LOGE(TAG, "Invalid OTA offset: %u", offset);
+            return false;
+        }
+        partition_ = partition;
+        mbedtls_sha256_starts(&sha256_, 0);
+        if (offset > 0 && !HashPartition(offset, prefix_sha256)) {
+            return false;
+        }
+        written_ = offset;
+        erased_end_ = offset;
+        last_checkpoint_ = offset;
+        running_ = true;
+        xTaskCreate([](void* arg) {
+            auto writer = (OtaFlashWriter*)arg;
+            writer->WriterLoop();
+            vTaskDelete(NULL);
+        }, "ota_writer", 4096, this, 5, nullptr);
+        return true;
+    }
+
+    // 取一块空闲缓冲区，写入任务出错时返回 false
+    bool Acquire(Buffer& buffer) {
+        xQueueReceive(free_buffers_, &buffer, portMAX_DELAY);
+        buffer.length = 0;
+        return error_ == ESP_OK;
+    }
+
+    // 把填好的缓冲区交给写入任务
+    bool Submit(const Buffer& buffer) {
+        if (buffer.length == 0 || !running_) {
+            xQueueSend(free_buffers_, &buffer, portMAX_DELAY);
+        } else {
+            xQueueSend(filled_buffers_, &buffer, portMAX_DELAY);
+        }
+        return error_ == ESP_OK;
+    }
+
+    // 等待所有缓冲区写完，输出整个镜像的 SHA-256
+    esp_err_t Finish(uint8_t sha256[32]) {
+        Stop();
+        if (error_ != ESP_OK) {
+            return error_;
+        }
+        ESP_LOGI(TAG, "Flash write speed: %u B/s", write_time_us_ > 0 ? (size_t)(write_bytes_ * 1000000LL / write_time_us_) : 0);
+        mbedtls_sha256_finish(&sha256_, sha256);
+        return ESP_OK;
+    }
+
+private:
+    uint8_t* buffers_ = nullptr;
+    size_t buffer_size_ = 0;
+    QueueHandle_t free_buffers_ = nullptr;
+    QueueHandle_t filled_buffers_ = nullptr;
+    SemaphoreHandle_t done_ = nullptr;
+    const esp_partition_t* partition_ = nullptr;
+    mbedtls_sha256_context sha256_;
+    bool running_ = false;
+    std::atomic<esp_err_t> error_{ESP_OK};
+    std::atomic<size_t> written_{0};
+    size_t erased_end_ = 0;
+    size_t last_checkpoint_ = 0;
+    size_t write_bytes_ = 0;
+    int64_t write_time_us_ = 0;
+    std::function<void(size_t offset, const std::string& sha256)> on_checkpoint_;
+
+    bool HashPartition(size_t length, const std::string& expected) {
+        auto start_time = esp_timer_get_time();
+        for (size_t offset = 0; offset < length; offset += buffer_size_) {
+            size_t size = std::min(buffer_size_, length - offset);
+            esp_err_t err = esp_partition_read(partition_, offset, buffers_, size);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to read partition: %s", esp_err_to_name(err));
+                return false;
+            }
+            mbedtls_sha256_update(&sha256_, buffers_, size);
+        }
+        if (GetCurrentHash() != expected) {
+            ESP_LOGW(TAG, "Data in partition %s does not match the saved checkpoint", partition_->label);
+            return false;
+        }
+        ESP_LOGI(TAG, "Verified %u bytes in partition %s in %lld ms", length, partition_->label,
+            (esp_timer_get_time() - start_time) / 1000);
+        return true;
+    }
+
+    std::string GetCurrentHash() {
+        mbedtls_sha256_context context;
+        uint8_t digest[32];
+        mbedtls_sha256_init(&context);
+        mbedtls_sha256_clone(&context, &sha256_);
+        mbedtls_sha256_finish(&context, digest);
+        mbedtls_sha256_free(&context);
+        return ToHexString(digest, sizeof(digest));
+    }
+
+    esp_err_t Write(const uint8_t* data, size_t length) {
+        size_t end = written_ + length;
+        if (end > partition_->size) {
+            ESP_LOGE(TAG, "Firmware image is larger than partition %s", partition_->label);
+            return ESP_ERR_INVALID_SIZE;
+        }
+        if (end > erased_end_) {
+            size_t erase_end = (end + OTA_SECTOR_SIZE - 1) / OTA_SECTOR_SIZE * OTA_SECTOR_SIZE;
+            esp_err_t err = esp_partition_erase_range(partition_, erased_end_, erase_end - erased_end_);
+            if (err != ESP_OK) {
+                return err;
+            }
+            erased_end_ = erase_end;
+        }
+        return esp_partition_write(partition_, written_, data, length);
+    }
+
+    void Stop() {
+        Buffer end = {
+            .data = nullptr,
+            .length = 0
+        };
+        xQueueSend(filled_buffers_, &end, portMAX_DELAY);
+        xSemaphoreTake(done_, portMAX_DELAY);
+        running_ = false;
+    }
+
+    void WriterLoop() {
+        while (true) {
+            Buffer buffer;
+            xQueueReceive(filled_buffers_, &buffer, portMAX_DELAY);
+            if (buffer.data == nullptr) {
+                break;
+            }
+            // 出错后继续归还缓冲区，让读取端尽快发现错误
+            if (error_ == ESP_OK) {
+                auto start_time = esp_timer_get_time();
+                esp_err_t err = Write(buffer.data, buffer.length);
+                write_time_us_ += esp_timer_get_time() - start_time;
+                if (err != ESP_OK) {
+                    ESP_LOGE(TAG, "Failed to write OTA data: %s", esp_err_to_name(err));
+                    error_ = err;
+                } else {
+                    mbedtls_sha256_update(&sha256_, buffer.data, buffer.length);
+                    written_ += buffer.length;
+                    write_bytes_ += buffer.length;
+                }
+            }
+            xQueueSend(free_buffers_, &buffer, portMAX_DELAY);
+
+            // 只在扇区边界保存断点，恢复时从一个完整擦除的扇区开始写
+            if (error_ == ESP_OK && on_checkpoint_ && written_ % OTA_SECTOR_SIZE == 0 &&
+                written_ - last_checkpoint_ >= OTA_CHECKPOINT_INTERVAL) {
+                last_checkpoint_ = written_;
+                on_checkpoint_(written_, GetCurrentHash());
+            }
+        }
+        xSemaphoreGive(done_);
+    }
+};
 
 Ota::Ota() {
 #ifdef ESP_EFUSE_BLOCK_USR_DATA
@@ -216,6 +473,12 @@ bool Ota::CheckVersion() {
         if (cJSON_IsString(url)) {
             firmware_url_ = url->valuestring;
         }
+        // 可选，用于下载完成后校验整个固件
+        firmware_sha256_.clear();
+        cJSON *sha256 = cJSON_GetObjectItem(firmware, "sha256");
+        if (cJSON_IsString(sha256)) {
+            firmware_sha256_ = sha256->valuestring;
+        }
 
         if (cJSON_IsString(version) && cJSON_IsString(url)) {
             // Check if the version is newer, for example, 0.1.0 is newer than 0.0.1
@@ -235,10 +498,27 @@ bool Ota::CheckVersion() {
         ESP_LOGW(TAG, "No firmware section found!");
     }
 
+    // 保存这次检查的结果，下次启动时可以直接使用 NVS 中的协议配置
+    Settings settings("ota", true);
+    settings.SetInt("activated", has_activation_code_ || has_activation_challenge_ ? 0 : 1);
+    settings.SetString("protocol", has_mqtt_config_ ? "mqtt" : has_websocket_config_ ? "websocket" : "");
+
     cJSON_Delete(root);
     return true;
 }
 
+bool Ota::LoadCachedConfig() {
+    current_version_ = esp_app_get_description()->version;
+    Settings settings("ota", false);
+    if (settings.GetInt("activated") != 1) {
+        return false;
+    }
+    auto protocol = settings.GetString("protocol");
+    has_mqtt_config_ = protocol == "mqtt";
+    has_websocket_config_ = protocol == "websocket";
+    return has_mqtt_config_ || has_websocket_config_;
+}
+
 void Ota::MarkCurrentVersionValid() {
     auto partition = esp_ota_get_running_partition();
     if (strcmp(partition->label, "factory") == 0) {
@@ -259,9 +539,34 @@ void Ota::MarkCurrentVersionValid() {
     }
 }
 
+void Ota::ClearUpgradeCheckpoint() {
+    Settings settings("ota", true);
+    settings.EraseKey("url");
+    settings.EraseKey("partition");
+    settings.EraseKey("offset");
+    settings.EraseKey("sha256");
+    Settings::Flush();
+}
+
+bool Ota::CheckImageHeader(const uint8_t* data, size_t length) {
+    if (length < sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t) + sizeof(esp_app_desc_t)) {
+        ESP_LOGE(TAG, "Firmware image is too small");
+        return false;
+    }
+    esp_app_desc_t new_app_info;
+    memcpy(&new_app_info, data + sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t), sizeof(esp_app_desc_t));
+    ESP_LOGI(TAG, "New firmware version: %s", new_app_info.version);
+
+    auto current_version = esp_app_get_description()->version;
+    if (memcmp(new_app_info.version, current_version, sizeof(new_app_info.version)) == 0) {
+        ESP_LOGE(TAG, "Firmware version is the same, skipping upgrade");
+        return false;
+    }
+    return true;
+}
+
 void Ota::Upgrade(const std::string& firmware_url) {
     ESP_LOGI(TAG, "Upgrading firmware from %s", firmware_url.c_str());
-    esp_ota_handle_t update_handle = 0;
     auto update_partition = esp_ota_get_next_update_partition(NULL);
     if (update_partition == NULL) {
         ESP_LOGE(TAG, "Failed to get update partition");
@@ -269,98 +574,233 @@ void Ota::Upgrade(const std::string& firmware_url) {
     }
 
     ESP_LOGI(TAG, "Writing to partition %s at offset 0x%lx", update_partition->label, update_partition->address);
-    bool image_header_checked = false;
-    std::string image_header;
-
-    auto http = std::unique_ptr<Http>(Board::GetInstance().CreateHttp());
-    if (!http->Open("GET", firmware_url)) {
-        ESP_LOGE(TAG, "Failed to open HTTP connection");
+    OtaFlashWriter writer;
+    if (!writer.IsValid()) {
         return;
     }
-
-    if (http->GetStatusCode() != 200) {
-        ESP_LOGE(TAG, "Failed to get firmware, status code: %d", http->GetStatusCode());
-        return;
+    writer.OnCheckpoint([&firmware_url, update_partition](size_t offset, const std::string& sha256) {
+        Settings settings("ota", true);
+        settings.SetString("url", firmware_url);
+        settings.SetString("partition", update_partition->label);
+        settings.SetInt("offset", offset);
+        settings.SetString("sha256", sha256);
+        // 断点必须立即写入 NVS，下载期间不断有新断点，延迟写回的定时器会一直被推后
+        Settings::Flush();
+    });
+
+    // 同一个固件地址上次没有下载完时，校验分区中已写入的数据后从断点继续
+    {
+        Settings settings("ota", false);
+        size_t offset = settings.GetInt("offset");
+        if (offset > 0 && settings.GetString("url") == firmware_url && settings.GetString("partition") == update_partition->label) {
+            if (writer.Begin(update_partition, offset, settings.GetString("sha256"))) {
+                ESP_LOGI(TAG, "Resuming firmware download from %u bytes", offset);
+            }
+        }
     }
-
-    size_t content_length = http->GetBodyLength();
-    if (content_length == 0) {
-        ESP_LOGE(TAG, "Failed to get content length");
-        return;
+    if (!writer.started()) {
+        ClearUpgradeCheckpoint();
     }
 
-    char buffer[512];
-    size_t total_read = 0, recent_read = 0;
+    size_t received = writer.written();
+    size_t total_size = 0;
+    size_t recent_read = 0;
     auto last_calc_time = esp_timer_get_time();
-    while (true) {
-        int ret = http->Read(buffer, sizeof(buffer));
-        if (ret < 0) {
-            ESP_LOGE(TAG, "Failed to read HTTP data: %s", esp_err_to_name(ret));
-            return;
+    OtaFlashWriter::Buffer buffer = {
+        .data = nullptr,
+        .length = 0
+    };
+
+    // 把当前缓冲区交给写入任务，第一块缓冲区先检查镜像头
+    auto submit_buffer = [&]() -> bool {
+        if (!writer.started() && (!CheckImageHeader(buffer.data, buffer.length) || !writer.Begin(update_partition, 0))) {
+            return false;
+        }
+        bool ok = writer.Submit(buffer);
+        buffer.data = nullptr;
+        return ok;
+    };
+
+    // 压缩或差分的升级包先读到输入缓冲区，解码后的镜像再复制到写入缓冲区
+    std::unique_ptr<OtaPackageDecoder> decoder;
+    std::vector<uint8_t> input;
+    auto on_decoded = [&](const uint8_t* data, size_t length) -> bool {
+        while (length > 0) {
+            if (buffer.data == nullptr && !writer.Acquire(buffer)) {
+                return false;
+            }
+            size_t n = std::min(length, writer.buffer_size() - buffer.length);
+            memcpy(buffer.data + buffer.length, data, n);
+            buffer.length += n;
+            data += n;
+            length -= n;
+            if (buffer.length == writer.buffer_size() && !submit_buffer()) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    int retries = 0;
+    bool eof = false;
+    while (!eof) {
+        if (retries > 0) {
+            if (retries > OTA_MAX_RETRIES) {
+                ESP_LOGE(TAG, "Failed to download firmware after %d retries, %u bytes saved for next time", OTA_MAX_RETRIES, writer.written());
+                return;
+            }
+            ESP_LOGW(TAG, "Retrying firmware download from %u bytes (%d/%d)", received, retries, OTA_MAX_RETRIES);
+            vTaskDelay(pdMS_TO_TICKS(OTA_RETRY_DELAY_MS * retries));
+        }
+
+        auto http = std::unique_ptr<Http>(Board::GetInstance().CreateHttp());
+        if (received > 0) {
+            http->SetHeader("Range", "bytes=" + std::to_string(received) + "-");
+        }
+        if (!http->Open("GET", firmware_url)) {
+            ESP_LOGE(TAG, "Failed to open HTTP connection");
+            retries++;
+            continue;
         }
 
-        // Calculate speed and progress every second
-        recent_read += ret;
-        total_read += ret;
-        if (esp_timer_get_time() - last_calc_time >= 1000000 || ret == 0) {
-            size_t progress = total_read * 100 / content_length;
-            ESP_LOGI(TAG, "Progress: %u%% (%u/%u), Speed: %uB/s", progress, total_read, content_length, recent_read);
-            if (upgrade_callback_) {
-                upgrade_callback_(progress, recent_read);
+        // 服务器不支持 Range 时会返回完整的文件，跳过已经收到的部分
+        size_t skip = 0;
+        auto status_code = http->GetStatusCode();
+        if (status_code == 206) {
+            total_size = received + http->GetBodyLength();
+        } else if (status_code == 200) {
+            total_size = http->GetBodyLength();
+            skip = received;
+            if (received > 0) {
+                ESP_LOGW(TAG, "Server does not support range requests, skipping %u bytes", received);
             }
-            last_calc_time = esp_timer_get_time();
-            recent_read = 0;
+        } else if (status_code >= 500) {
+            ESP_LOGE(TAG, "Failed to get firmware, status code: %d", status_code);
+            retries++;
+            continue;
+        } else {
+            ESP_LOGE(TAG, "Failed to get firmware, status code: %d", status_code);
+            ClearUpgradeCheckpoint();
+            return;
         }
 
-        if (ret == 0) {
-            break;
+        if (total_size == 0 || total_size <= received) {
+            ESP_LOGE(TAG, "Failed to get content length");
+            ClearUpgradeCheckpoint();
+            return;
         }
 
-        if (!image_header_checked) {
-            image_header.append(buffer, ret);
-            if (image_header.size() >= sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t) + sizeof(esp_app_desc_t)) {
-                esp_app_desc_t new_app_info;
-                memcpy(&new_app_info, image_header.data() + sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t), sizeof(esp_app_desc_t));
-                ESP_LOGI(TAG, "New firmware version: %s", new_app_info.version);
+        bool failed = false;
+        while (true) {
+            if (buffer.data == nullptr && !writer.Acquire(buffer)) {
+                return;
+            }
 
-                auto current_version = esp_app_get_description()->version;
-                if (memcmp(new_app_info.version, current_version, sizeof(new_app_info.version)) == 0) {
-                    ESP_LOGE(TAG, "Firmware version is the same, skipping upgrade");
+            uint8_t* target = decoder ? input.data() : buffer.data + buffer.length;
+            size_t space = decoder ? input.size() : writer.buffer_size() - buffer.length;
+            int ret = http->Read((char*)target, space);
+            if (ret < 0) {
+                ESP_LOGE(TAG, "Failed to read HTTP data: %s", esp_err_to_name(ret));
+                failed = true;
+                break;
+            }
+            if (ret == 0) {
+                // 连接提前关闭也按网络错误处理
+                eof = received >= total_size;
+                failed = !eof;
+                break;
+            }
+            recent_read += ret;
+            if (skip > 0) {
+                size_t n = std::min(skip, (size_t)ret);
+                memmove(target, target + n, ret - n);
+                skip -= n;
+                ret -= n;
+            }
+            received += ret;
+            if (ret > 0) {
+                retries = 0;
+            }
+
+            if (received == (size_t)ret && OtaPackageDecoder::IsPackage(target, ret)) {
+                ESP_LOGI(TAG, "Firmware is a compressed or delta package");
+                // 下载的数据与写入分区的镜像不再一一对应，升级包不保存断点
+                writer.OnCheckpoint(nullptr);
+                decoder = std::make_unique<OtaPackageDecoder>(on_decoded);
+                input.resize(OTA_PACKAGE_INPUT_SIZE);
+                std::vector<uint8_t> head(target, target + ret);
+                if (!decoder->Feed(head.data(), head.size())) {
                     return;
                 }
-
-                if (esp_ota_begin(update_partition, OTA_WITH_SEQUENTIAL_WRITES, &update_handle)) {
-                    esp_ota_abort(update_handle);
-                    ESP_LOGE(TAG, "Failed to begin OTA");
+            } else if (decoder) {
+                if (!decoder->Feed(input.data(), ret)) {
                     return;
                 }
+            } else {
+                buffer.length += ret;
+                if (buffer.length == writer.buffer_size() && !submit_buffer()) {
+                    return;
+                }
+            }
 
-                image_header_checked = true;
-                std::string().swap(image_header);
+            // Calculate speed and progress every second
+            if (esp_timer_get_time() - last_calc_time >= 1000000) {
+                size_t image_size = decoder ? decoder->image_size() : total_size;
+                size_t progress = image_size > 0 ? writer.written() * 100 / image_size : 0;
+                ESP_LOGI(TAG, "Progress: %u%% (downloaded %u / %u, written %u / %u), Speed: %uB/s",
+                    progress, received, total_size, writer.written(), image_size, recent_read);
+                if (upgrade_callback_) {
+                    upgrade_callback_(progress, recent_read);
+                }
+                last_calc_time = esp_timer_get_time();
+                recent_read = 0;
             }
         }
-        auto err = esp_ota_write(update_handle, buffer, ret);
-        if (err != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to write OTA data: %s", esp_err_to_name(err));
-            esp_ota_abort(update_handle);
-            return;
+        http->Close();
+        if (failed) {
+            if (decoder) {
+                ESP_LOGE(TAG, "Package download interrupted and cannot be resumed");
+                return;
+            }
+            retries++;
         }
     }
-    http->Close();
 
-    esp_err_t err = esp_ota_end(update_handle);
+    if (decoder && !decoder->Finish()) {
+        return;
+    }
+    if (buffer.data != nullptr && !submit_buffer()) {
+        return;
+    }
+
+    uint8_t sha256[32];
+    esp_err_t err = writer.Finish(sha256);
     if (err != ESP_OK) {
-        if (err == ESP_ERR_OTA_VALIDATE_FAILED) {
-            ESP_LOGE(TAG, "Image validation failed, image is corrupted");
-        } else {
-            ESP_LOGE(TAG, "Failed to end OTA: %s", esp_err_to_name(err));
-        }
+        ESP_LOGE(TAG, "Failed to write firmware: %s", esp_err_to_name(err));
+        ClearUpgradeCheckpoint();
+        return;
+    }
+    // 下载完成后不再需要断点，校验失败时也要从头下载
+    ClearUpgradeCheckpoint();
+
+    auto digest = ToHexString(sha256, sizeof(sha256));
+    ESP_LOGI(TAG, "Firmware SHA-256: %s", digest.c_str());
+    if (!firmware_sha256_.empty() && strcasecmp(firmware_sha256_.c_str(), digest.c_str()) != 0) {
+        ESP_LOGE(TAG, "Firmware SHA-256 mismatch, expected %s", firmware_sha256_.c_str());
         return;
     }
+    if (upgrade_callback_) {
+        upgrade_callback_(100, recent_read);
+    }
 
+    // 设置启动分区前会校验整个镜像
     err = esp_ota_set_boot_partition(update_partition);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to set boot partition: %s", esp_err_to_name(err));
+        if (err == ESP_ERR_OTA_VALIDATE_FAILED) {
+            ESP_LOGE(TAG, "Image validation failed, image is corrupted");
+        } else {
+            ESP_LOGE(TAG, "Failed to set boot partition: %s", esp_err_to_name(err));
+        }
         return;
     }
 
@@ -370,6 +810,8 @@ void Ota::Upgrade(const std::string& firmware_url) {
 }
 
 void Ota::StartUpgrade(std::function<void(int progress, size_t speed)> callback) {
+    // 升级时间较长且结束后直接重启，先把设置写回 NVS
+    Settings::Flush();
     upgrade_callback_ = callback;
     Upgrade(firmware_url_);
 }
@@ -13,6 +13,7 @@ public:
     ~Ota();
 
     bool CheckVersion();
+    bool LoadCachedConfig();
     esp_err_t Activate();
     bool HasActivationChallenge() { return has_activation_challenge_; }
     bool HasNewVersion() { return has_new_version_; }
@@ -42,11 +43,14 @@ private:
     std::string current_version_;
     std::string firmware_version_;
     std::string firmware_url_;
+    std::string firmware_sha256_;
     std::string activation_challenge_;
     std::string serial_number_;
     int activation_timeout_ms_ = 30000;
 
     void Upgrade(const std::string& firmware_url);
+    bool CheckImageHeader(const uint8_t* data, size_t length);
+    void ClearUpgradeCheckpoint();
     std::function<void(int progress, size_t speed)> upgrade_callback_;
     std::vector<int> ParseVersion(const std::string& version);
     bool IsNewVersionAvailable(const std::string& currentVersion, const std::string& newVersion);
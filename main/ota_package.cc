@@ -0,0 +1,286 @@
+#include "ota_package.h"
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <esp_ota_ops.h>
+#include <mbedtls/sha256.h>
+
+#include <cstring>
+#include <algorithm>
+
+#define TAG "OtaPackage"
+
+#define COPY_BUFFER_SIZE 4096
+
+static uint32_t ReadUint32(const uint8_t* data) {
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static void* AllocateBuffer(size_t size) {
+    void* buffer = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    if (buffer == nullptr) {
+        buffer = heap_caps_malloc(size, MALLOC_CAP_8BIT);
+    }
+    return buffer;
+}
+
+OtaPackageDecoder::OtaPackageDecoder(std::function<bool(const uint8_t* data, size_t length)> output)
+    : output_(output) {
+}
+
+OtaPackageDecoder::~OtaPackageDecoder() {
+    if (inflator_ != nullptr) {
+        heap_caps_free(inflator_);
+    }
+    if (dictionary_ != nullptr) {
+        heap_caps_free(dictionary_);
+    }
+    if (copy_buffer_ != nullptr) {
+        heap_caps_free(copy_buffer_);
+    }
+}
+
+bool OtaPackageDecoder::IsPackage(const uint8_t* data, size_t length) {
+    return length >= 4 && memcmp(data, OTA_PACKAGE_MAGIC, 4) == 0;
+}
+
+bool OtaPackageDecoder::Feed(const uint8_t* data, size_t length) {
+    if (state_ == kStateError) {
+        return false;
+    }
+
+    if (state_ == kStateHeader) {
+        size_t n = std::min(length, OTA_PACKAGE_HEADER_SIZE - header_length_);
+        memcpy(header_ + header_length_, data, n);
+        header_length_ += n;
+        data += n;
+        length -= n;
+        if (header_length_ < OTA_PACKAGE_HEADER_SIZE) {
+            return true;
+        }
+        if (!ParseHeader()) {
+            state_ = kStateError;
+            return false;
+        }
+    }
+
+    if (length == 0) {
+        return true;
+    }
+    bool ok;
+    if (flags_ & OTA_PACKAGE_FLAG_COMPRESSED) {
+        // 压缩流结束后的多余数据直接忽略
+        ok = inflate_done_ || Inflate(data, length, true);
+    } else {
+        ok = Decode(data, length);
+    }
+    if (!ok) {
+        state_ = kStateError;
+    }
+    return ok;
+}
+
+bool OtaPackageDecoder::Finish() {
+    if (state_ == kStateError || state_ == kStateHeader) {
+        ESP_LOGE(TAG, "Incomplete package");
+        return false;
+    }
+    if ((flags_ & OTA_PACKAGE_FLAG_COMPRESSED) && !inflate_done_ && !Inflate(nullptr, 0, false)) {
+        state_ = kStateError;
+        return false;
+    }
+    if ((flags_ & OTA_PACKAGE_FLAG_DELTA) && state_ != kStateDone) {
+        ESP_LOGE(TAG, "Delta instructions are truncated");
+        return false;
+    }
+    if (output_size_ != image_size_) {
+        ESP_LOGE(TAG, "Image size mismatch, expected %u, got %u", image_size_, output_size_);
+        return false;
+    }
+    return true;
+}
+
+bool OtaPackageDecoder::ParseHeader() {
+    if (!IsPackage(header_, header_length_)) {
+        ESP_LOGE(TAG, "Invalid package magic");
+        return false;
+    }
+    flags_ = ReadUint32(header_ + 4);
+    image_size_ = ReadUint32(header_ + 8);
+    base_size_ = ReadUint32(header_ + 12);
+    ESP_LOGI(TAG, "Package flags: 0x%lx, image size: %u, base size: %u", flags_, image_size_, base_size_);
+
+    if (flags_ & OTA_PACKAGE_FLAG_COMPRESSED) {
+        inflator_ = (tinfl_decompressor*)AllocateBuffer(sizeof(tinfl_decompressor));
+        dictionary_ = (uint8_t*)AllocateBuffer(TINFL_LZ_DICT_SIZE);
+        if (inflator_ == nullptr || dictionary_ == nullptr) {
+            ESP_LOGE(TAG, "Failed to allocate inflate buffers");
+            return false;
+        }
+        tinfl_init(inflator_);
+    }
+
+    if (flags_ & OTA_PACKAGE_FLAG_DELTA) {
+        base_partition_ = esp_ota_get_running_partition();
+        if (base_partition_ == nullptr || base_size_ > base_partition_->size) {
+            ESP_LOGE(TAG, "Invalid delta base size: %u", base_size_);
+            return false;
+        }
+        copy_buffer_ = (uint8_t*)AllocateBuffer(COPY_BUFFER_SIZE);
+        if (copy_buffer_ == nullptr) {
+            ESP_LOGE(TAG, "Failed to allocate copy buffer");
+            return false;
+        }
+        if (!VerifyBase(header_ + 16)) {
+            return false;
+        }
+        state_ = kStateOpcode;
+    } else {
+        state_ = kStateInsert;
+    }
+    return true;
+}
+
+bool OtaPackageDecoder::VerifyBase(const uint8_t* expected_sha256) {
+    mbedtls_sha256_context context;
+    uint8_t digest[32];
+    mbedtls_sha256_init(&context);
+    mbedtls_sha256_starts(&context, 0);
+    for (size_t offset = 0; offset < base_size_; offset += COPY_BUFFER_SIZE) {
+        size_t size = std::min((size_t)COPY_BUFFER_SIZE, base_size_ - offset);
+        if (esp_partition_read(base_partition_, offset, copy_buffer_, size) != ESP_OK) {
+            mbedtls_sha256_free(&context);
+            ESP_LOGE(TAG, "Failed to read running partition");
+            return false;
+        }
+        mbedtls_sha256_update(&context, copy_buffer_, size);
+    }
+    mbedtls_sha256_finish(&context, digest);
+    mbedtls_sha256_free(&context);
+
+    if (memcmp(digest, expected_sha256, sizeof(digest)) != 0) {
+        ESP_LOGE(TAG, "Delta package was made for a different firmware than partition %s", base_partition_->label);
+        return false;
+    }
+    return true;
+}
+
+bool OtaPackageDecoder::Inflate(const uint8_t* data, size_t length, bool has_more) {
+    while (true) {
+        size_t in_bytes = length;
+        size_t out_bytes = TINFL_LZ_DICT_SIZE - dictionary_offset_;
+        auto status = tinfl_decompress(inflator_, data, &in_bytes, dictionary_, dictionary_ + dictionary_offset_,
+            &out_bytes, has_more ? TINFL_FLAG_HAS_MORE_INPUT : 0);
+        data += in_bytes;
+        length -= in_bytes;
+
+        if (out_bytes > 0 && !Decode(dictionary_ + dictionary_offset_, out_bytes)) {
+            return false;
+        }
+        dictionary_offset_ = (dictionary_offset_ + out_bytes) & (TINFL_LZ_DICT_SIZE - 1);
+
+        if (status < TINFL_STATUS_DONE) {
+            ESP_LOGE(TAG, "Failed to inflate package: %d", status);
+            return false;
+        }
+        if (status == TINFL_STATUS_DONE) {
+            inflate_done_ = true;
+            return true;
+        }
+        if (status == TINFL_STATUS_NEEDS_MORE_INPUT && length == 0) {
+            return true;
+        }
+    }
+}
+
+bool OtaPackageDecoder::Decode(const uint8_t* data, size_t length) {
+    if (!(flags_ & OTA_PACKAGE_FLAG_DELTA)) {
+        return Emit(data, length);
+    }
+
+    while (length > 0) {
+        switch (state_) {
+        case kStateOpcode:
+            opcode_ = *data++;
+            length--;
+            arguments_length_ = 0;
+            if (opcode_ == 0x00) {
+                state_ = kStateDone;
+            } else if (opcode_ == 0x01 || opcode_ == 0x02) {
+                state_ = kStateArguments;
+            } else {
+                ESP_LOGE(TAG, "Unknown delta opcode: 0x%02x", opcode_);
+                return false;
+            }
+            break;
+        case kStateArguments: {
+            size_t needed = opcode_ == 0x01 ? 8 : 4;
+            size_t n = std::min(needed - arguments_length_, length);
+            memcpy(arguments_ + arguments_length_, data, n);
+            arguments_length_ += n;
+            data += n;
+            length -= n;
+            if (arguments_length_ < needed) {
+                break;
+            }
+            if (opcode_ == 0x01) {
+                if (!Copy(ReadUint32(arguments_), ReadUint32(arguments_ + 4))) {
+                    return false;
+                }
+                state_ = kStateOpcode;
+            } else {
+                insert_remaining_ = ReadUint32(arguments_);
+                state_ = insert_remaining_ > 0 ? kStateInsert : kStateOpcode;
+            }
+            break;
+        }
+        case kStateInsert: {
+            size_t n = std::min(insert_remaining_, length);
+            if (!Emit(data, n)) {
+                return false;
+            }
+            data += n;
+            length -= n;
+            insert_remaining_ -= n;
+            if (insert_remaining_ == 0) {
+                state_ = kStateOpcode;
+            }
+            break;
+        }
+        case kStateDone:
+            return true;
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+bool OtaPackageDecoder::Copy(size_t offset, size_t length) {
+    if (offset > base_size_ || length > base_size_ - offset) {
+        ESP_LOGE(TAG, "Delta copy out of range: %u+%u", offset, length);
+        return false;
+    }
+    while (length > 0) {
+        size_t size = std::min((size_t)COPY_BUFFER_SIZE, length);
+        if (esp_partition_read(base_partition_, offset, copy_buffer_, size) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to read running partition");
+            return false;
+        }
+        if (!Emit(copy_buffer_, size)) {
+            return false;
+        }
+        offset += size;
+        length -= size;
+    }
+    return true;
+}
+
+bool OtaPackageDecoder::Emit(const uint8_t* data, size_t length) {
+    if (length > image_size_ - output_size_) {
+        ESP_LOGE(TAG, "Package output exceeds image size %u", image_size_);
+        return false;
+    }
+    output_size_ += length;
+    return output_(data, length);
+}
@@ -0,0 +1,85 @@
+#ifndef OTA_PACKAGE_H
+#define OTA_PACKAGE_H
+
+#include <esp_partition.h>
+#include <rom/miniz.h>
+
+#include <functional>
+#include <string>
+
+// 压缩或差分的固件升级包，由 scripts/ota_package.py 生成。
+//
+// 包头（小端）:
+//   magic[4]        "XZO1"
+//   flags           bit0: 负载为 raw deflate 压缩；bit1: 负载为相对当前运行分区的差分指令
+//   image_size      还原后的固件大小
+//   base_size       差分时参与计算的运行分区长度
+//   base_sha256[32] 运行分区前 base_size 字节的 SHA-256，用于确认差分的基准固件
+//
+// 差分指令（压缩时为解压后的数据）:
+//   0x00                        结束
+//   0x01 offset(4) length(4)    从运行分区复制
+//   0x02 length(4) data[length] 插入新数据
+#define OTA_PACKAGE_MAGIC "XZO1"
+#define OTA_PACKAGE_HEADER_SIZE 48
+#define OTA_PACKAGE_FLAG_COMPRESSED (1 << 0)
+#define OTA_PACKAGE_FLAG_DELTA (1 << 1)
+
+class OtaPackageDecoder {
+public:
+    // output 返回 false 时停止解码
+    OtaPackageDecoder(std::function<bool(const uint8_t* data, size_t length)> output);
+    ~OtaPackageDecoder();
+
+    static bool IsPackage(const uint8_t* data, size_t length);
+
+    bool Feed(const uint8_t* data, size_t length);
+    // 数据全部输入后调用，检查包是否完整
+    bool Finish();
+
+    // 解析到包头之后才有效
+    size_t image_size() const { return image_size_; }
+    size_t output_size() const { return output_size_; }
+
+private:
+    enum State {
+        kStateHeader,
+        kStateOpcode,
+        kStateArguments,
+        kStateInsert,
+        kStateDone,
+        kStateError,
+    };
+
+    std::function<bool(const uint8_t* data, size_t length)> output_;
+    State state_ = kStateHeader;
+    uint8_t header_[OTA_PACKAGE_HEADER_SIZE];
+    size_t header_length_ = 0;
+    uint32_t flags_ = 0;
+    size_t image_size_ = 0;
+    size_t output_size_ = 0;
+
+    // 解压使用 ROM 中的 tinfl，输出写入 32KB 的环形字典
+    tinfl_decompressor* inflator_ = nullptr;
+    uint8_t* dictionary_ = nullptr;
+    size_t dictionary_offset_ = 0;
+    bool inflate_done_ = false;
+
+    // 差分
+    const esp_partition_t* base_partition_ = nullptr;
+    size_t base_size_ = 0;
+    uint8_t* copy_buffer_ = nullptr;
+    uint8_t opcode_ = 0;
+    uint8_t arguments_[8];
+    size_t arguments_length_ = 0;
+    size_t insert_remaining_ = 0;
+
+    bool ParseHeader();
+    bool VerifyBase(const uint8_t* expected_sha256);
+    bool Inflate(const uint8_t* data, size_t length, bool has_more);
+    bool Decode(const uint8_t* data, size_t length);
+    bool Emit(const uint8_t* data, size_t length);
+    bool Copy(size_t offset, size_t length);
+};
+
+#endif // OTA_PACKAGE_H
@@ -31,6 +31,18 @@ void Protocol::SetError(const std::string& message) {
     }
 }
 
+bool Protocol::CanSendImage() const {
+    return false;
+}
+
+bool Protocol::CanStreamVision() const {
+    return false;
+}
+
+bool Protocol::SendImage(const std::vector<uint8_t>& jpeg) {
+    return false;
+}
+
 void Protocol::SendAbortSpeaking(AbortReason reason) {
     std::string message = "{\"session_id\":\"" + session_id_ + "\",\"type\":\"abort\"";
     if (reason == kAbortReasonWakeWordDetected) {
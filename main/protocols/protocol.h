@@ -11,20 +11,22 @@ struct AudioStreamPacket {
     int sample_rate = 0;
     int frame_duration = 0;
     uint32_t timestamp = 0;
+    // 上行帧的设备端回环延迟（毫秒），用于服务端 AEC
+    uint32_t loopback_delay = 0;
     std::vector<uint8_t> payload;
 };
 
 struct BinaryProtocol2 {
     uint16_t version;
-    uint16_t type;          // Message type (0: OPUS, 1: JSON)
-    uint32_t reserved;      // Reserved for future use
+    uint16_t type;          // Message type (0: OPUS, 1: JSON, 2: JPEG)
+    uint32_t reserved;      // Device-side loopback delay in milliseconds for uplink audio (server-side AEC), otherwise 0
     uint32_t timestamp;     // Timestamp in milliseconds (used for server-side AEC)
     uint32_t payload_size;  // Payload size in bytes
     uint8_t payload[];      // Payload data
 } __attribute__((packed));
 
 struct BinaryProtocol3 {
-    uint8_t type;
+    uint8_t type;           // Message type (0: OPUS, 2: JPEG)
     uint8_t reserved;
     uint16_t payload_size;
     uint8_t payload[];
@@ -66,6 +68,10 @@ public:
     virtual void CloseAudioChannel() = 0;
     virtual bool IsAudioChannelOpened() const = 0;
     virtual bool SendAudio(const AudioStreamPacket& packet) = 0;
+    virtual bool CanSendImage() const;
+    // 服务器在 hello 中确认支持连续视觉模式
+    virtual bool CanStreamVision() const;
+    virtual bool SendImage(const std::vector<uint8_t>& jpeg);
     virtual void SendWakeWordDetected(const std::string& wake_word);
     virtual void SendStartListening(ListeningMode mode);
     virtual void SendStopListening();
@@ -39,7 +39,7 @@ bool WebsocketProtocol::SendAudio(const AudioStreamPacket& packet) {
         auto bp2 = (BinaryProtocol2*)serialized.data();
         bp2->version = htons(version_);
         bp2->type = 0;
-        bp2->reserved = 0;
+        bp2->reserved = htonl(packet.loopback_delay);
         bp2->timestamp = htonl(packet.timestamp);
         bp2->payload_size = htonl(packet.payload.size());
         memcpy(bp2->payload, packet.payload.data(), packet.payload.size());
@@ -60,6 +60,47 @@ bool WebsocketProtocol::SendAudio(const AudioStreamPacket& packet) {
     }
 }
 
+bool WebsocketProtocol::CanSendImage() const {
+    // 版本 1 的二进制帧只能是音频
+    return version_ == 2 || version_ == 3;
+}
+
+bool WebsocketProtocol::CanStreamVision() const {
+    return CanSendImage() && server_vision_stream_;
+}
+
+bool WebsocketProtocol::SendImage(const std::vector<uint8_t>& jpeg) {
+    if (websocket_ == nullptr) {
+        return false;
+    }
+
+    std::string serialized;
+    if (version_ == 2) {
+        serialized.resize(sizeof(BinaryProtocol2) + jpeg.size());
+        auto bp2 = (BinaryProtocol2*)serialized.data();
+        bp2->version = htons(version_);
+        bp2->type = htons(2);
+        bp2->reserved = 0;
+        bp2->timestamp = 0;
+        bp2->payload_size = htonl(jpeg.size());
+        memcpy(bp2->payload, jpeg.data(), jpeg.size());
+    } else if (version_ == 3) {
+        if (jpeg.size() > UINT16_MAX) {
+            ESP_LOGW(TAG, "Image too large for protocol version 3: %u bytes", jpeg.size());
+            return false;
+        }
+        serialized.resize(sizeof(BinaryProtocol3) + jpeg.size());
+        auto bp3 = (BinaryProtocol3*)serialized.data();
+        bp3->type = 2;
+        bp3->reserved = 0;
+        bp3->payload_size = htons(jpeg.size());
+        memcpy(bp3->payload, jpeg.data(), jpeg.size());
+    } else {
+        return false;
+    }
+    return websocket_->Send(serialized.data(), serialized.size(), true);
+}
+
 bool WebsocketProtocol::SendText(const std::string& text) {
     if (websocket_ == nullptr) {
         return false;
@@ -99,6 +140,7 @@ bool WebsocketProtocol::OpenAudioChannel() {
     }
 
     error_occurred_ = false;
+    server_vision_stream_ = false;
 
     websocket_ = Board::GetInstance().CreateWebSocket();
     
@@ -215,6 +257,11 @@ std::string WebsocketProtocol::GetHelloMessage() {
 #endif
 #if CONFIG_IOT_PROTOCOL_MCP
     cJSON_AddBoolToObject(features, "mcp", true);
+#endif
+#if CONFIG_USE_VISION_STREAMING
+    if (CanSendImage() && Board::GetInstance().GetCamera() != nullptr) {
+        cJSON_AddBoolToObject(features, "vision_stream", true);
+    }
 #endif
     cJSON_AddItemToObject(root, "features", features);
     cJSON_AddStringToObject(root, "transport", "websocket");
@@ -256,5 +303,11 @@ void WebsocketProtocol::ParseServerHello(const cJSON* root) {
         }
     }
 
+    // 旧的服务器不认识 type 为 2 的二进制帧，只有明确确认后才发送画面
+    auto features = cJSON_GetObjectItem(root, "features");
+    if (cJSON_IsObject(features)) {
+        server_vision_stream_ = cJSON_IsTrue(cJSON_GetObjectItem(features, "vision_stream"));
+    }
+
     xEventGroupSetBits(event_group_handle_, WEBSOCKET_PROTOCOL_SERVER_HELLO_EVENT);
 }
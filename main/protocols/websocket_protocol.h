@@ -17,6 +17,9 @@ public:
 
     bool Start() override;
     bool SendAudio(const AudioStreamPacket& packet) override;
+    bool CanSendImage() const override;
+    bool CanStreamVision() const override;
+    bool SendImage(const std::vector<uint8_t>& jpeg) override;
     bool OpenAudioChannel() override;
     void CloseAudioChannel() override;
     bool IsAudioChannelOpened() const override;
@@ -25,6 +28,7 @@ private:
     EventGroupHandle_t event_group_handle_;
     WebSocket* websocket_ = nullptr;
     int version_ = 1;
+    bool server_vision_stream_ = false;
 
     void ParseServerHello(const cJSON* root);
     bool SendText(const std::string& text) override;
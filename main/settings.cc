@@ -1,58 +1,292 @@
 #include "settings.h"
 
 #include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_system.h>
 #include <nvs_flash.h>
 
+#include <map>
+#include <algorithm>
+#include <mutex>
+
 #define TAG "Settings"
 
-Settings::Settings(const std::string& ns, bool read_write) : ns_(ns), read_write_(read_write) {
-    nvs_open(ns.c_str(), read_write_ ? NVS_READWRITE : NVS_READONLY, &nvs_handle_);
-}
+// 最后一次修改之后等待这么久再写回 NVS，连续调节音量等操作只写一次
+#define SETTINGS_FLUSH_DELAY_MS 3000
 
-Settings::~Settings() {
-    if (nvs_handle_ != 0) {
-        if (read_write_ && dirty_) {
-            ESP_ERROR_CHECK(nvs_commit(nvs_handle_));
+class SettingsCache {
+public:
+    static SettingsCache& GetInstance() {
+        static SettingsCache instance;
+        return instance;
+    }
+    SettingsCache(const SettingsCache&) = delete;
+    SettingsCache& operator=(const SettingsCache&) = delete;
+
+    bool GetString(const std::string& ns, const std::string& key, std::string& value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& entries = GetNamespace(ns).entries;
+        auto it = entries.find(key);
+        if (it == entries.end() || it->second.erased || it->second.type != NVS_TYPE_STR) {
+            return false;
         }
-        nvs_close(nvs_handle_);
+        value = it->second.string_value;
+        return true;
     }
-}
 
-std::string Settings::GetString(const std::string& key, const std::string& default_value) {
-    if (nvs_handle_ == 0) {
-        return default_value;
+    bool GetInt(const std::string& ns, const std::string& key, int32_t& value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& entries = GetNamespace(ns).entries;
+        auto it = entries.find(key);
+        if (it == entries.end() || it->second.erased || it->second.type != NVS_TYPE_I32) {
+            return false;
+        }
+        value = it->second.int_value;
+        return true;
     }
 
-    size_t length = 0;
-    if (nvs_get_str(nvs_handle_, key.c_str(), nullptr, &length) != ESP_OK) {
-        return default_value;
+    void SetString(const std::string& ns, const std::string& key, const std::string& value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& entry = GetNamespace(ns).entries[key];
+        if (!entry.erased && entry.type == NVS_TYPE_STR && entry.string_value == value) {
+            return;
+        }
+        entry.type = NVS_TYPE_STR;
+        entry.string_value = value;
+        entry.erased = false;
+        MarkDirty(ns, entry);
+    }
+
+    void SetInt(const std::string& ns, const std::string& key, int32_t value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& entry = GetNamespace(ns).entries[key];
+        if (!entry.erased && entry.type == NVS_TYPE_I32 && entry.int_value == value) {
+            return;
+        }
+        entry.type = NVS_TYPE_I32;
+        entry.int_value = value;
+        entry.erased = false;
+        MarkDirty(ns, entry);
+    }
+
+    void EraseKey(const std::string& ns, const std::string& key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& entries = GetNamespace(ns).entries;
+        auto it = entries.find(key);
+        if (it == entries.end() || it->second.erased) {
+            return;
+        }
+        it->second.erased = true;
+        MarkDirty(ns, it->second);
+    }
+
+    void EraseAll(const std::string& ns) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& cached = GetNamespace(ns);
+        cached.entries.clear();
+        cached.erase_all = true;
+        cached.dirty = true;
+        ScheduleFlush();
+    }
+
+    void Flush() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (flush_timer_ != nullptr) {
+            esp_timer_stop(flush_timer_);
+        }
+        for (auto& [ns, cached] : namespaces_) {
+            if (cached.dirty) {
+                FlushNamespace(ns, cached);
+            }
+        }
+    }
+
+private:
+    struct Entry {
+        nvs_type_t type = NVS_TYPE_ANY;
+        std::string string_value;
+        int32_t int_value = 0;
+        bool dirty = false;
+        bool erased = false;
+    };
+
+    struct Namespace {
+        std::map<std::string, Entry> entries;
+        bool erase_all = false;
+        bool dirty = false;
+    };
+
+    std::mutex mutex_;
+    std::map<std::string, Namespace> namespaces_;
+    esp_timer_handle_t flush_timer_ = nullptr;
+
+    SettingsCache() {
+        esp_timer_create_args_t timer_args = {
+            .callback = [](void* arg) {
+                ((SettingsCache*)arg)->Flush();
+            },
+            .arg = this,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "settings_flush",
+            .skip_unhandled_events = true,
+        };
+        esp_timer_create(&timer_args, &flush_timer_);
+
+        // esp_restart() 之前写回所有修改
+        esp_register_shutdown_handler([]() {
+            SettingsCache::GetInstance().Flush();
+        });
+    }
+
+    // 调用时需要持有 mutex_
+    Namespace& GetNamespace(const std::string& ns) {
+        auto it = namespaces_.find(ns);
+        if (it != namespaces_.end()) {
+            return it->second;
+        }
+        auto& cached = namespaces_[ns];
+        Load(ns, cached);
+        return cached;
     }
 
+    void Load(const std::string& ns, Namespace& cached) {
+        nvs_handle_t nvs_handle;
+        if (nvs_open(ns.c_str(), NVS_READONLY, &nvs_handle) != ESP_OK) {
+            // 命名空间还不存在
+            return;
+        }
+
+        nvs_iterator_t it = nullptr;
+        esp_err_t err = nvs_entry_find(NVS_DEFAULT_PART_NAME, ns.c_str(), NVS_TYPE_ANY, &it);
+        while (err == ESP_OK) {
+            nvs_entry_info_t info;
+            nvs_entry_info(it, &info);
+            if (info.type == NVS_TYPE_STR) {
+                size_t length = 0;
+                if (nvs_get_str(nvs_handle, info.key, nullptr, &length) == ESP_OK) {
+                    auto& entry = cached.entries[info.key];
+                    entry.type = NVS_TYPE_STR;
+                    entry.string_value.resize(length);
+                    nvs_get_str(nvs_handle, info.key, entry.string_value.data(), &length);
+                    while (!entry.string_value.empty() && entry.string_value.back() == '\0') {
+                        entry.string_value.pop_back();
+                    }
+                }
+            } else if (info.type == NVS_TYPE_I32) {
+                auto& entry = cached.entries[info.key];
+                entry.type = NVS_TYPE_I32;
+                nvs_get_i32(nvs_handle, info.key, &entry.int_value);
+            }
+            err = nvs_entry_next(&it);
+        }
+        nvs_release_iterator(it);
+        nvs_close(nvs_handle);
+        ESP_LOGD(TAG, "Loaded %u keys from namespace %s", cached.entries.size(), ns.c_str());
+    }
+
+    // 调用时需要持有 mutex_
+    void MarkDirty(const std::string& ns, Entry& entry) {
+        entry.dirty = true;
+        namespaces_[ns].dirty = true;
+        ScheduleFlush();
+    }
+
+    void ScheduleFlush() {
+        if (flush_timer_ == nullptr) {
+            return;
+        }
+        esp_timer_stop(flush_timer_);
+        esp_timer_start_once(flush_timer_, SETTINGS_FLUSH_DELAY_MS * 1000);
+    }
+
+    void FlushNamespace(const std::string& ns, Namespace& cached) {
+        nvs_handle_t nvs_handle;
+        esp_err_t err = nvs_open(ns.c_str(), NVS_READWRITE, &nvs_handle);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to open namespace %s: %s", ns.c_str(), esp_err_to_name(err));
+            return;
+        }
+
+        if (cached.erase_all) {
+            err = nvs_erase_all(nvs_handle);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to erase namespace %s: %s", ns.c_str(), esp_err_to_name(err));
+                nvs_close(nvs_handle);
+                return;
+            }
+            cached.erase_all = false;
+        }
+
+        int count = 0;
+        for (auto it = cached.entries.begin(); it != cached.entries.end();) {
+            auto& entry = it->second;
+            if (!entry.dirty) {
+                ++it;
+                continue;
+            }
+            if (entry.erased) {
+                err = nvs_erase_key(nvs_handle, it->first.c_str());
+                if (err == ESP_ERR_NVS_NOT_FOUND) {
+                    err = ESP_OK;
+                }
+            } else if (entry.type == NVS_TYPE_STR) {
+                err = nvs_set_str(nvs_handle, it->first.c_str(), entry.string_value.c_str());
+            } else {
+                err = nvs_set_i32(nvs_handle, it->first.c_str(), entry.int_value);
+            }
+            if (err != ESP_OK) {
+                // 保留脏标记，下次再试
+                ESP_LOGE(TAG, "Failed to write %s.%s: %s", ns.c_str(), it->first.c_str(), esp_err_to_name(err));
+                ++it;
+                continue;
+            }
+            count++;
+            entry.dirty = false;
+            if (entry.erased) {
+                it = cached.entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        err = nvs_commit(nvs_handle);
+        nvs_close(nvs_handle);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to commit namespace %s: %s", ns.c_str(), esp_err_to_name(err));
+            return;
+        }
+        cached.dirty = std::any_of(cached.entries.begin(), cached.entries.end(), [](const auto& item) {
+            return item.second.dirty;
+        });
+        ESP_LOGI(TAG, "Flushed %d changes to namespace %s", count, ns.c_str());
+    }
+};
+
+Settings::Settings(const std::string& ns, bool read_write) : ns_(ns), read_write_(read_write) {
+}
+
+Settings::~Settings() {
+}
+
+std::string Settings::GetString(const std::string& key, const std::string& default_value) {
     std::string value;
-    value.resize(length);
-    ESP_ERROR_CHECK(nvs_get_str(nvs_handle_, key.c_str(), value.data(), &length));
-    while (!value.empty() && value.back() == '\0') {
-        value.pop_back();
+    if (!SettingsCache::GetInstance().GetString(ns_, key, value)) {
+        return default_value;
     }
     return value;
 }
 
 void Settings::SetString(const std::string& key, const std::string& value) {
     if (read_write_) {
-        ESP_ERROR_CHECK(nvs_set_str(nvs_handle_, key.c_str(), value.c_str()));
-        dirty_ = true;
+        SettingsCache::GetInstance().SetString(ns_, key, value);
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
 }
 
 int32_t Settings::GetInt(const std::string& key, int32_t default_value) {
-    if (nvs_handle_ == 0) {
-        return default_value;
-    }
-
     int32_t value;
-    if (nvs_get_i32(nvs_handle_, key.c_str(), &value) != ESP_OK) {
+    if (!SettingsCache::GetInstance().GetInt(ns_, key, value)) {
         return default_value;
     }
     return value;
@@ -60,8 +294,7 @@ int32_t Settings::GetInt(const std::string& key, int32_t default_value) {
 
 void Settings::SetInt(const std::string& key, int32_t value) {
     if (read_write_) {
-        ESP_ERROR_CHECK(nvs_set_i32(nvs_handle_, key.c_str(), value));
-        dirty_ = true;
+        SettingsCache::GetInstance().SetInt(ns_, key, value);
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
@@ -69,10 +302,7 @@ void Settings::SetInt(const std::string& key, int32_t value) {
 
 void Settings::EraseKey(const std::string& key) {
     if (read_write_) {
-        auto ret = nvs_erase_key(nvs_handle_, key.c_str());
-        if (ret != ESP_ERR_NVS_NOT_FOUND) {
-            ESP_ERROR_CHECK(ret);
-        }
+        SettingsCache::GetInstance().EraseKey(ns_, key);
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
@@ -80,8 +310,12 @@ void Settings::EraseKey(const std::string& key) {
 
 void Settings::EraseAll() {
     if (read_write_) {
-        ESP_ERROR_CHECK(nvs_erase_all(nvs_handle_));
+        SettingsCache::GetInstance().EraseAll(ns_);
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
 }
+
+void Settings::Flush() {
+    SettingsCache::GetInstance().Flush();
+}
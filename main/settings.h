@@ -4,6 +4,8 @@
 #include <string>
 #include <nvs_flash.h>
 
+// 读写都在内存缓存中完成：命名空间第一次使用时从 NVS 整体加载，
+// 修改合并后延迟写回，调用 Flush() 或重启前立即写回
 class Settings {
 public:
     Settings(const std::string& ns, bool read_write = false);
@@ -16,11 +18,12 @@ public:
     void EraseKey(const std::string& key);
     void EraseAll();
 
+    // 把所有未写回的修改提交到 NVS
+    static void Flush();
+
 private:
     std::string ns_;
-    nvs_handle_t nvs_handle_ = 0;
     bool read_write_ = false;
-    bool dirty_ = false;
 };
 
 #endif
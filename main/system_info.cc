@@ -8,6 +8,7 @@
 #include <esp_partition.h>
 #include <esp_app_desc.h>
 #include <esp_ota_ops.h>
+#include <esp_pm.h>
 #if CONFIG_IDF_TARGET_ESP32P4
 #include "esp_wifi_remote.h"
 #endif
@@ -143,3 +144,36 @@ void SystemInfo::PrintHeapStats() {
     int min_free_sram = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
     ESP_LOGI(TAG, "free sram: %u minimal sram: %u", free_sram, min_free_sram);
 }
+
+int SystemInfo::GetCpuBusyPermille(int core) {
+    static configRUN_TIME_COUNTER_TYPE last_idle[CONFIG_FREERTOS_NUMBER_OF_CORES] = {};
+    static configRUN_TIME_COUNTER_TYPE last_total[CONFIG_FREERTOS_NUMBER_OF_CORES] = {};
+    if (core < 0 || core >= CONFIG_FREERTOS_NUMBER_OF_CORES) {
+        return -1;
+    }
+
+    configRUN_TIME_COUNTER_TYPE idle = ulTaskGetRunTimeCounter(xTaskGetIdleTaskHandleForCore(core));
+    configRUN_TIME_COUNTER_TYPE total = portGET_RUN_TIME_COUNTER_VALUE();
+    configRUN_TIME_COUNTER_TYPE idle_elapsed = idle - last_idle[core];
+    configRUN_TIME_COUNTER_TYPE total_elapsed = total - last_total[core];
+    last_idle[core] = idle;
+    last_total[core] = total;
+    if (total_elapsed == 0 || idle_elapsed > total_elapsed) {
+        return 0;
+    }
+    return 1000 - (int)((uint64_t)idle_elapsed * 1000 / total_elapsed);
+}
+
+void SystemInfo::PrintDutyCycle() {
+    char line[64];
+    int length = 0;
+    for (int core = 0; core < CONFIG_FREERTOS_NUMBER_OF_CORES; core++) {
+        int busy = GetCpuBusyPermille(core);
+        length += snprintf(line + length, sizeof(line) - length, " cpu%d: %d.%d%%", core, busy / 10, busy % 10);
+    }
+    ESP_LOGI(TAG, "busy duty cycle:%s", line);
+#if CONFIG_PM_PROFILING
+    // 各个锁的持有时间与各功耗模式的停留时间，包括浅睡眠
+    esp_pm_dump_locks(stdout);
+#endif
+}
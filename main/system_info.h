@@ -16,6 +16,9 @@ public:
     static esp_err_t PrintTaskCpuUsage(TickType_t xTicksToWait);
     static void PrintTaskList();
     static void PrintHeapStats();
+    // 自上次调用以来各核的忙碌占比（千分比），IDLE 任务（包括其中的自动浅睡眠）之外的时间都算忙碌
+    static int GetCpuBusyPermille(int core);
+    static void PrintDutyCycle();
 };
 
 #endif // _SYSTEM_INFO_H_
@@ -0,0 +1,175 @@
+#include "vision_streamer.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <algorithm>
+#include <cstdlib>
+
+#define TAG "VisionStreamer"
+
+#define VISION_RUN_EVENT (1 << 0)
+
+// 用于判断画面变化的亮度缩略图尺寸
+#define LUMA_WIDTH 32
+#define LUMA_HEIGHT 24
+// 平均每个像素的亮度差超过该值才认为画面有变化
+#define CHANGE_THRESHOLD 6
+// 画面一直不变时，也按这个间隔刷新一次
+#define KEYFRAME_INTERVAL_MS 10000
+
+#define FRAME_MAX_WIDTH 320
+#define MIN_QUALITY 20
+#define MAX_QUALITY 60
+#define MAX_INTERVAL_MS 5000
+// 每次发送顺利时增加的带宽预算（字节/秒）
+#define BUDGET_STEP_BPS 1000
+#define MIN_BUDGET_BPS 2000
+
+VisionStreamer::VisionStreamer(Camera* camera) : camera_(camera) {
+    budget_bps_ = CONFIG_VISION_STREAM_MAX_KBPS * 1000 / 8;
+    quality_ = MAX_QUALITY;
+    interval_ms_ = 1000 / CONFIG_VISION_STREAM_MAX_FPS;
+    luma_.resize(LUMA_WIDTH * LUMA_HEIGHT);
+
+    event_group_ = xEventGroupCreate();
+    xTaskCreate([](void* arg) {
+        auto streamer = (VisionStreamer*)arg;
+        streamer->StreamLoop();
+        vTaskDelete(NULL);
+    }, "vision_stream", 4096 * 2, this, 2, &task_handle_);
+}
+
+VisionStreamer::~VisionStreamer() {
+    if (task_handle_ != nullptr) {
+        vTaskDelete(task_handle_);
+    }
+    if (event_group_ != nullptr) {
+        vEventGroupDelete(event_group_);
+    }
+}
+
+void VisionStreamer::OnFrame(std::function<void(std::vector<uint8_t>&& jpeg)> callback) {
+    on_frame_ = callback;
+}
+
+void VisionStreamer::Start() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        reset_ = true;
+        frame_in_flight_ = false;
+    }
+    ESP_LOGI(TAG, "Vision streaming started");
+    xEventGroupSetBits(event_group_, VISION_RUN_EVENT);
+}
+
+void VisionStreamer::Stop() {
+    xEventGroupClearBits(event_group_, VISION_RUN_EVENT);
+    ESP_LOGI(TAG, "Vision streaming stopped, sent %d frames, skipped %d unchanged frames", frames_sent_, frames_skipped_);
+}
+
+void VisionStreamer::ReportAudioSent(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto now = esp_timer_get_time();
+    audio_bytes_ += bytes;
+    if (audio_window_start_ == 0) {
+        audio_window_start_ = now;
+    } else if (now - audio_window_start_ >= 1000000) {
+        audio_bps_ = audio_bytes_ * 1000000 / (now - audio_window_start_);
+        audio_bytes_ = 0;
+        audio_window_start_ = now;
+    }
+}
+
+void VisionStreamer::ReportFrameSent(size_t bytes, int64_t duration_us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    frame_in_flight_ = false;
+
+    // 发送耗时超过帧间隔的一半说明上行拥塞，乘性减小预算，否则加性增大
+    int max_budget = CONFIG_VISION_STREAM_MAX_KBPS * 1000 / 8;
+    if (duration_us / 1000 > interval_ms_ / 2) {
+        budget_bps_ = std::max(budget_bps_ * 7 / 10, MIN_BUDGET_BPS);
+    } else {
+        budget_bps_ = std::min(budget_bps_ + BUDGET_STEP_BPS, max_budget);
+    }
+
+    // 视频只使用音频剩下的带宽，帧间隔按这一帧的大小计算
+    int available = std::max(budget_bps_ - audio_bps_, MIN_BUDGET_BPS / 2);
+    int interval = bytes * 1000 / available;
+    int min_interval = 1000 / CONFIG_VISION_STREAM_MAX_FPS;
+    if (interval > MAX_INTERVAL_MS) {
+        interval = MAX_INTERVAL_MS;
+        quality_ = std::max(quality_ - 10, MIN_QUALITY);
+    } else if (interval < min_interval) {
+        interval = min_interval;
+        quality_ = std::min(quality_ + 5, MAX_QUALITY);
+    }
+    interval_ms_ = interval;
+    ESP_LOGD(TAG, "Frame %u bytes sent in %lld ms, budget %d B/s, audio %d B/s, next interval %d ms, quality %d",
+        bytes, duration_us / 1000, budget_bps_, audio_bps_, interval_ms_, quality_);
+}
+
+bool VisionStreamer::HasChanged() const {
+    int total = 0;
+    for (size_t i = 0; i < luma_.size(); i++) {
+        total += abs((int)luma_[i] - (int)last_luma_[i]);
+    }
+    return total > CHANGE_THRESHOLD * (int)luma_.size();
+}
+
+void VisionStreamer::StreamLoop() {
+    while (true) {
+        xEventGroupWaitBits(event_group_, VISION_RUN_EVENT, pdFALSE, pdTRUE, portMAX_DELAY);
+
+        int interval_ms;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (reset_) {
+                // 新的会话，第一帧总是发送
+                reset_ = false;
+                last_luma_.clear();
+                frames_sent_ = 0;
+                frames_skipped_ = 0;
+            }
+            interval_ms = interval_ms_;
+        }
+        vTaskDelay(pdMS_TO_TICKS(interval_ms));
+        if (!(xEventGroupGetBits(event_group_) & VISION_RUN_EVENT)) {
+            continue;
+        }
+
+        int quality;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            // 上一帧还没发完，说明上行带宽不足，这一轮不采集
+            if (frame_in_flight_) {
+                continue;
+            }
+            quality = quality_;
+        }
+
+        if (!camera_->CaptureStreamFrame(luma_.data(), LUMA_WIDTH, LUMA_HEIGHT)) {
+            continue;
+        }
+        auto now = esp_timer_get_time();
+        if (!last_luma_.empty() && !HasChanged() && now - last_sent_time_ < KEYFRAME_INTERVAL_MS * 1000) {
+            frames_skipped_++;
+            continue;
+        }
+
+        std::vector<uint8_t> jpeg;
+        if (!camera_->EncodeStreamFrame(jpeg, FRAME_MAX_WIDTH, quality)) {
+            ESP_LOGW(TAG, "Failed to encode stream frame");
+            continue;
+        }
+        last_luma_ = luma_;
+        last_sent_time_ = now;
+        frames_sent_++;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            frame_in_flight_ = true;
+        }
+        if (on_frame_) {
+            on_frame_(std::move(jpeg));
+        }
+    }
+}
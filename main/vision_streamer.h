@@ -0,0 +1,54 @@
+#ifndef VISION_STREAMER_H
+#define VISION_STREAMER_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+#include <freertos/task.h>
+
+#include <functional>
+#include <vector>
+#include <mutex>
+
+#include "camera.h"
+
+// 连续视觉模式：会话期间以较低帧率把摄像头画面编码为 JPEG 交给上层发送。
+// 帧率与 JPEG 质量根据音频之外剩余的上行带宽自动调整，画面没有变化时跳过。
+class VisionStreamer {
+public:
+    VisionStreamer(Camera* camera);
+    ~VisionStreamer();
+
+    // 回调在采集任务中调用，发送完成后需要调用 ReportFrameSent
+    void OnFrame(std::function<void(std::vector<uint8_t>&& jpeg)> callback);
+    void Start();
+    void Stop();
+    void ReportFrameSent(size_t bytes, int64_t duration_us);
+    void ReportAudioSent(size_t bytes);
+
+private:
+    Camera* camera_;
+    TaskHandle_t task_handle_ = nullptr;
+    EventGroupHandle_t event_group_ = nullptr;
+    std::function<void(std::vector<uint8_t>&& jpeg)> on_frame_;
+
+    std::mutex mutex_;
+    bool reset_ = false;
+    bool frame_in_flight_ = false;
+    int budget_bps_;
+    int audio_bps_ = 0;
+    size_t audio_bytes_ = 0;
+    int64_t audio_window_start_ = 0;
+    int quality_;
+    int interval_ms_;
+
+    std::vector<uint8_t> luma_;
+    std::vector<uint8_t> last_luma_;
+    int64_t last_sent_time_ = 0;
+    int frames_sent_ = 0;
+    int frames_skipped_ = 0;
+
+    void StreamLoop();
+    bool HasChanged() const;
+};
+
+#endif // VISION_STREAMER_H
@@ -0,0 +1,177 @@
+#! /usr/bin/env python3
+"""
+生成与校验压缩/差分 OTA 升级包，格式与 main/ota_package.h 一致。
+
+  # 压缩的完整固件
+  python scripts/ota_package.py create build/xiaozhi.bin -o xiaozhi.xzo
+  # 相对旧固件的差分包（设备当前运行的必须是 old.bin）
+  python scripts/ota_package.py create build/xiaozhi.bin --base old.bin -o xiaozhi-delta.xzo
+  # 用参考解码器还原并与新固件比对
+  python scripts/ota_package.py verify xiaozhi-delta.xzo build/xiaozhi.bin --base old.bin
+"""
+import sys
+import struct
+import hashlib
+import zlib
+import argparse
+
+MAGIC = b"XZO1"
+HEADER_FORMAT = "<4sIII32s"
+HEADER_SIZE = struct.calcsize(HEADER_FORMAT)
+FLAG_COMPRESSED = 1 << 0
+FLAG_DELTA = 1 << 1
+
+OP_END = 0x00
+OP_COPY = 0x01
+OP_INSERT = 0x02
+
+# 差分匹配的最小长度，旧固件每隔 INDEX_STEP 字节建一次索引
+BLOCK_SIZE = 32
+INDEX_STEP = 16
+
+
+def make_delta(base, image):
+    index = {}
+    for i in range(0, len(base) - BLOCK_SIZE + 1, INDEX_STEP):
+        index.setdefault(base[i:i + BLOCK_SIZE], i)
+
+    out = bytearray()
+    literal_start = 0
+    i = 0
+
+    def emit_insert(end):
+        if end > literal_start:
+            out.extend(struct.pack("<BI", OP_INSERT, end - literal_start))
+            out.extend(image[literal_start:end])
+
+    while i + BLOCK_SIZE <= len(image):
+        j = index.get(image[i:i + BLOCK_SIZE])
+        if j is None:
+            i += 1
+            continue
+        # 向前扩展到上一段的末尾，再向后尽量延长
+        while i > literal_start and j > 0 and image[i - 1] == base[j - 1]:
+            i -= 1
+            j -= 1
+        length = BLOCK_SIZE
+        while i + length < len(image) and j + length < len(base):
+            step = min(4096, len(image) - i - length, len(base) - j - length)
+            if image[i + length:i + length + step] == base[j + length:j + length + step]:
+                length += step
+            elif image[i + length] == base[j + length]:
+                length += 1
+            else:
+                break
+        emit_insert(i)
+        out.extend(struct.pack("<BII", OP_COPY, j, length))
+        i += length
+        literal_start = i
+
+    emit_insert(len(image))
+    out.append(OP_END)
+    return bytes(out)
+
+
+def apply_delta(base, delta):
+    out = bytearray()
+    pos = 0
+    while True:
+        op = delta[pos]
+        pos += 1
+        if op == OP_END:
+            return bytes(out)
+        elif op == OP_COPY:
+            offset, length = struct.unpack_from("<II", delta, pos)
+            pos += 8
+            if offset + length > len(base):
+                raise ValueError("copy out of range")
+            out.extend(base[offset:offset + length])
+        elif op == OP_INSERT:
+            (length,) = struct.unpack_from("<I", delta, pos)
+            pos += 4
+            out.extend(delta[pos:pos + length])
+            pos += length
+        else:
+            raise ValueError("unknown opcode 0x%02x" % op)
+
+
+def create(image, base=None, compress=True):
+    flags = 0
+    base_size = 0
+    base_sha256 = bytes(32)
+    payload = image
+    if base is not None:
+        flags |= FLAG_DELTA
+        base_size = len(base)
+        base_sha256 = hashlib.sha256(base).digest()
+        payload = make_delta(base, image)
+    if compress:
+        flags |= FLAG_COMPRESSED
+        compressor = zlib.compressobj(9, zlib.DEFLATED, -15)
+        payload = compressor.compress(payload) + compressor.flush()
+    header = struct.pack(HEADER_FORMAT, MAGIC, flags, len(image), base_size, base_sha256)
+    return header + payload
+
+
+def decode(package, base=None):
+    magic, flags, image_size, base_size, base_sha256 = struct.unpack_from(HEADER_FORMAT, package)
+    if magic != MAGIC:
+        raise ValueError("invalid magic")
+    payload = package[HEADER_SIZE:]
+    if flags & FLAG_COMPRESSED:
+        payload = zlib.decompressobj(-15).decompress(payload)
+    if flags & FLAG_DELTA:
+        if base is None:
+            raise ValueError("delta package requires --base")
+        if hashlib.sha256(base[:base_size]).digest() != base_sha256:
+            raise ValueError("base firmware does not match the package")
+        payload = apply_delta(base[:base_size], payload)
+    if len(payload) != image_size:
+        raise ValueError("image size mismatch, expected %d, got %d" % (image_size, len(payload)))
+    return payload
+
+
+def read_file(path):
+    with open(path, "rb") as f:
+        return f.read()
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="生成与校验压缩/差分 OTA 升级包")
+    subparsers = parser.add_subparsers(dest="command", required=True)
+
+    create_parser = subparsers.add_parser("create", help="生成升级包")
+    create_parser.add_argument("image", help="新固件 .bin")
+    create_parser.add_argument("-o", "--output", required=True)
+    create_parser.add_argument("--base", help="设备当前运行的旧固件 .bin，指定时生成差分包")
+    create_parser.add_argument("--no-compress", action="store_true", help="不压缩负载")
+
+    verify_parser = subparsers.add_parser("verify", help="还原升级包并与新固件比对")
+    verify_parser.add_argument("package")
+    verify_parser.add_argument("image", help="新固件 .bin")
+    verify_parser.add_argument("--base", help="旧固件 .bin")
+
+    args = parser.parse_args()
+    image = read_file(args.image)
+    base = read_file(args.base) if args.base else None
+
+    if args.command == "create":
+        package = create(image, base, not args.no_compress)
+        # 生成后立即用参考解码器验证一遍
+        if decode(package, base) != image:
+            print("Failed to verify the generated package")
+            sys.exit(1)
+        with open(args.output, "wb") as f:
+            f.write(package)
+        print("Package %s: %d bytes (%.1f%% of %d bytes), sha256 of image: %s" % (
+            args.output, len(package), len(package) * 100 / len(image), len(image), hashlib.sha256(image).hexdigest()))
+    else:
+        try:
+            decoded = decode(read_file(args.package), base)
+        except ValueError as e:
+            print("Invalid package: %s" % e)
+            sys.exit(1)
+        if decoded != image:
+            print("Decoded image does not match %s" % args.image)
+            sys.exit(1)
+        print("OK")
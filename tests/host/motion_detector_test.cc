@@ -0,0 +1,224 @@
+// MotionDetector 的测试与性能评估。
+//
+// 不带参数时用合成画面检查 ROI、阈值与冷却逻辑，并输出每帧的处理耗时；
+// 带 --frames 时逐帧处理录制的亮度图（width * height 字节一帧，首尾相接），输出每帧的结果与耗时：
+//   motion_detector_test --frames recorded.luma [--width 64] [--height 48] [--roi x,y,w,h]
+//       [--threshold pixel,area] [--cooldown N]
+
+#include "motion_detector.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <vector>
+
+#define WIDTH 64
+#define HEIGHT 48
+
+static int failures = 0;
+
+#define EXPECT(condition, message) do { \
+    if (!(condition)) { \
+        fprintf(stderr, "FAIL: %s (%s:%d)\n", message, __FILE__, __LINE__); \
+        failures++; \
+    } \
+} while (0)
+
+// 带传感器噪声的静态场景，可以叠加整体亮度偏移和一个方块
+class Scene {
+public:
+    Scene() : random_(7), background_(WIDTH * HEIGHT), frame_(WIDTH * HEIGHT) {
+        for (int y = 0; y < HEIGHT; y++) {
+            for (int x = 0; x < WIDTH; x++) {
+                background_[y * WIDTH + x] = 60 + (x * 2 + y) % 80;
+            }
+        }
+    }
+
+    const uint8_t* Render(int brightness = 0, int box_x = -1, int box_y = -1, int box_size = 20) {
+        std::uniform_int_distribution<int> noise(-3, 3);
+        for (int y = 0; y < HEIGHT; y++) {
+            for (int x = 0; x < WIDTH; x++) {
+                int value = background_[y * WIDTH + x] + brightness + noise(random_);
+                if (box_x >= 0 && x >= box_x && x < box_x + box_size && y >= box_y && y < box_y + box_size) {
+                    value = 230;
+                }
+                frame_[y * WIDTH + x] = std::clamp(value, 0, 255);
+            }
+        }
+        return frame_.data();
+    }
+
+private:
+    std::mt19937 random_;
+    std::vector<int> background_;
+    std::vector<uint8_t> frame_;
+};
+
+// 输入若干帧，返回检测到运动的次数
+static int FeedFrames(MotionDetector& detector, Scene& scene, int frames, int brightness = 0, int box_x = -1, int box_y = -1) {
+    int detections = 0;
+    for (int i = 0; i < frames; i++) {
+        if (detector.Feed(scene.Render(brightness, box_x, box_y))) {
+            detections++;
+        }
+    }
+    return detections;
+}
+
+static void TestStaticScene() {
+    MotionDetector detector(WIDTH, HEIGHT);
+    Scene scene;
+    EXPECT(FeedFrames(detector, scene, 100) == 0, "sensor noise must not be reported as motion");
+}
+
+static void TestBrightnessChange() {
+    MotionDetector detector(WIDTH, HEIGHT);
+    Scene scene;
+    FeedFrames(detector, scene, 10);
+    // 开灯或自动曝光造成的整体变化
+    EXPECT(FeedFrames(detector, scene, 3, 40) == 0, "a global brightness step must not be reported as motion");
+}
+
+static void TestObjectInRoi() {
+    MotionDetector detector(WIDTH, HEIGHT);
+    Scene scene;
+    FeedFrames(detector, scene, 10);
+    EXPECT(FeedFrames(detector, scene, 2, 0, 24, 16) == 1, "an object entering the scene must be reported after two frames");
+    EXPECT(detector.changed_percent() >= 10, "changed_percent must cover the object");
+}
+
+static void TestObjectOutsideRoi() {
+    MotionDetector detector(WIDTH, HEIGHT);
+    detector.SetRoi(0, 0, WIDTH / 2, HEIGHT);
+    Scene scene;
+    FeedFrames(detector, scene, 10);
+    EXPECT(FeedFrames(detector, scene, 5, 0, 44, 16) == 0, "motion outside the ROI must be ignored");
+    EXPECT(FeedFrames(detector, scene, 5, 0, 8, 16) > 0, "motion inside the ROI must be reported");
+}
+
+static void TestThreshold() {
+    MotionDetector detector(WIDTH, HEIGHT);
+    // 方块占整幅画面约 13%，面积阈值为 20% 时不应触发
+    detector.SetThreshold(20, 20);
+    Scene scene;
+    FeedFrames(detector, scene, 10);
+    EXPECT(FeedFrames(detector, scene, 5, 0, 24, 16) == 0, "a change below the area threshold must be ignored");
+}
+
+static void TestCooldown() {
+    MotionDetector detector(WIDTH, HEIGHT);
+    detector.SetCooldown(20);
+    Scene scene;
+    FeedFrames(detector, scene, 5);
+    EXPECT(FeedFrames(detector, scene, 10, 0, 24, 16) == 0, "motion during the cooldown must not be reported");
+    // 背景跟上停下的方块后，方块移走才是新的变化
+    FeedFrames(detector, scene, 30, 0, 24, 16);
+    EXPECT(FeedFrames(detector, scene, 5, 0, 4, 4) > 0, "motion after the cooldown must be reported");
+
+    detector.Reset();
+    FeedFrames(detector, scene, 5, 0, 4, 4);
+    EXPECT(FeedFrames(detector, scene, 10, 0, 40, 20) == 0, "Reset must restart the cooldown");
+}
+
+static void Benchmark(MotionDetector& detector, const std::vector<std::vector<uint8_t>>& frames, int rounds) {
+    int detections = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        for (auto& frame : frames) {
+            detections += detector.Feed(frame.data());
+        }
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    printf("  %d frames, %d detections, %.0f ns per frame\n", (int)(rounds * frames.size()), detections,
+        (double)elapsed / (rounds * frames.size()));
+}
+
+static int RunRecorded(int argc, char** argv) {
+    const char* path = nullptr;
+    int width = WIDTH, height = HEIGHT;
+    int roi[4] = { -1, -1, -1, -1 };
+    int pixel_threshold = 20, area_percent = 10, cooldown = 0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--frames") == 0) {
+            path = argv[i + 1];
+        } else if (strcmp(argv[i], "--width") == 0) {
+            width = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--height") == 0) {
+            height = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--roi") == 0) {
+            sscanf(argv[i + 1], "%d,%d,%d,%d", &roi[0], &roi[1], &roi[2], &roi[3]);
+        } else if (strcmp(argv[i], "--threshold") == 0) {
+            sscanf(argv[i + 1], "%d,%d", &pixel_threshold, &area_percent);
+        } else if (strcmp(argv[i], "--cooldown") == 0) {
+            cooldown = atoi(argv[i + 1]);
+        }
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return 2;
+    }
+    MotionDetector detector(width, height);
+    if (roi[0] >= 0) {
+        detector.SetRoi(roi[0], roi[1], roi[2], roi[3]);
+    }
+    detector.SetThreshold(pixel_threshold, area_percent);
+    detector.SetCooldown(cooldown);
+
+    std::vector<uint8_t> frame(width * height);
+    int64_t total_ns = 0;
+    int count = 0;
+    while (file.read((char*)frame.data(), frame.size())) {
+        auto start = std::chrono::steady_clock::now();
+        bool detected = detector.Feed(frame.data());
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        total_ns += elapsed;
+        printf("frame %d: changed %d%%%s, %lld ns\n", count, detector.changed_percent(), detected ? ", MOTION" : "", (long long)elapsed);
+        count++;
+    }
+    if (count > 0) {
+        printf("%d frames, %.0f ns per frame\n", count, (double)total_ns / count);
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        return RunRecorded(argc, argv);
+    }
+
+    TestStaticScene();
+    TestBrightnessChange();
+    TestObjectInRoi();
+    TestObjectOutsideRoi();
+    TestThreshold();
+    TestCooldown();
+
+    // 性能：一段有运动的合成画面反复输入
+    Scene scene;
+    std::vector<std::vector<uint8_t>> frames;
+    for (int i = 0; i < 64; i++) {
+        const uint8_t* luma = scene.Render(0, i % 2 == 0 ? i % 48 : -1, 16);
+        frames.emplace_back(luma, luma + WIDTH * HEIGHT);
+    }
+    MotionDetector full(WIDTH, HEIGHT);
+    printf("Full frame %dx%d:\n", WIDTH, HEIGHT);
+    Benchmark(full, frames, 200);
+    MotionDetector roi(WIDTH, HEIGHT);
+    roi.SetRoi(16, 12, 32, 24);
+    printf("ROI 32x24:\n");
+    Benchmark(roi, frames, 200);
+
+    if (failures > 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("All checks passed\n");
+    return 0;
+}
@@ -0,0 +1,106 @@
+// 用 scripts/ota_package.py 生成的升级包测试设备端的流式解码器 OtaPackageDecoder：
+// 以随机大小分块输入，覆盖包头、差分指令与参数、压缩流被切断在块边界上的情况，
+// 还原结果必须与目标固件逐字节一致。
+//
+//   ota_package_test <package> <image> [--base <base>] [--expect-fail] [--rounds N] [--seed S]
+
+#include "ota_package.h"
+#include "esp_ota_ops.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+static std::vector<uint8_t> ReadFile(const char* path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        fprintf(stderr, "Failed to open %s\n", path);
+        exit(2);
+    }
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// 返回解码是否成功，成功时 output 为还原的固件
+static bool DecodeInChunks(const std::vector<uint8_t>& package, std::mt19937& random, int max_chunk, std::vector<uint8_t>& output) {
+    output.clear();
+    OtaPackageDecoder decoder([&output](const uint8_t* data, size_t length) {
+        output.insert(output.end(), data, data + length);
+        return true;
+    });
+
+    std::uniform_int_distribution<int> chunk_size(1, max_chunk);
+    size_t offset = 0;
+    while (offset < package.size()) {
+        size_t n = std::min((size_t)chunk_size(random), package.size() - offset);
+        if (!decoder.Feed(package.data() + offset, n)) {
+            return false;
+        }
+        offset += n;
+    }
+    return decoder.Finish();
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <package> <image> [--base <base>] [--expect-fail] [--rounds N] [--seed S]\n", argv[0]);
+        return 2;
+    }
+    auto package = ReadFile(argv[1]);
+    auto image = ReadFile(argv[2]);
+    std::vector<uint8_t> base;
+    bool expect_fail = false;
+    int rounds = 20;
+    unsigned seed = 1;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--base") == 0 && i + 1 < argc) {
+            base = ReadFile(argv[++i]);
+        } else if (strcmp(argv[i], "--expect-fail") == 0) {
+            expect_fail = true;
+        } else if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+            rounds = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoul(argv[++i], nullptr, 10);
+        }
+    }
+    host_set_running_partition(base.data(), base.size());
+
+    std::mt19937 random(seed);
+    // 先用单字节输入，再用随机大小，最后整包一次输入
+    std::vector<int> max_chunks = { 1 };
+    for (int i = 0; i < rounds; i++) {
+        max_chunks.push_back(std::uniform_int_distribution<int>(2, 8192)(random));
+    }
+    max_chunks.push_back((int)package.size());
+
+    std::vector<uint8_t> output;
+    for (int max_chunk : max_chunks) {
+        bool ok = DecodeInChunks(package, random, max_chunk, output);
+        if (expect_fail) {
+            if (ok && output == image) {
+                fprintf(stderr, "FAIL: %s decoded although it should be rejected (max chunk %d)\n", argv[1], max_chunk);
+                return 1;
+            }
+            continue;
+        }
+        if (!ok) {
+            fprintf(stderr, "FAIL: %s was rejected (max chunk %d)\n", argv[1], max_chunk);
+            return 1;
+        }
+        if (output != image) {
+            size_t i = 0;
+            while (i < output.size() && i < image.size() && output[i] == image[i]) {
+                i++;
+            }
+            fprintf(stderr, "FAIL: %s output differs at byte %zu, got %zu bytes, expected %zu (max chunk %d)\n",
+                argv[1], i, output.size(), image.size(), max_chunk);
+            return 1;
+        }
+    }
+    printf("OK %s: %zu decodes%s\n", argv[1], max_chunks.size(), expect_fail ? " rejected" : "");
+    return 0;
+}
@@ -0,0 +1,160 @@
+// PcmRingBuffer 的测试：回绕、读取者落后时跳到最早的数据、Clear 与 Snapshot，
+// 以及构造之后写入与读取不再分配内存
+
+#include "audio_processing/pcm_ring_buffer.h"
+
+#include <esp_heap_caps.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#define CAPACITY 1000
+
+static int failures = 0;
+static size_t new_allocations = 0;
+
+// 统计 operator new 的调用次数，heap_caps_malloc 的次数由 stub 统计
+void* operator new(size_t size) {
+    new_allocations++;
+    void* ptr = malloc(size ? size : 1);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+
+#define EXPECT_EQ(actual, expected, message) do { \
+    long long a = (long long)(actual), e = (long long)(expected); \
+    if (a != e) { \
+        fprintf(stderr, "FAIL: %s: got %lld, expected %lld (%s:%d)\n", message, a, e, __FILE__, __LINE__); \
+        failures++; \
+    } \
+} while (0)
+
+// 采样值由它在流中的位置决定，读出的数据可以直接对照位置检查
+static int16_t SampleAt(uint64_t position) {
+    return (int16_t)(position * 7 % 32749);
+}
+
+// 从 position 开始写入 samples 个采样，返回新的位置
+static uint64_t WriteSamples(PcmRingBuffer& buffer, uint64_t position, size_t samples) {
+    std::vector<int16_t> data(samples);
+    for (size_t i = 0; i < samples; i++) {
+        data[i] = SampleAt(position + i);
+    }
+    buffer.Write(data.data(), samples);
+    return position + samples;
+}
+
+// 检查从 first 开始的 count 个采样与写入时一致
+static bool Matches(const int16_t* data, uint64_t first, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (data[i] != SampleAt(first + i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void TestWrapAround() {
+    PcmRingBuffer buffer(CAPACITY);
+    uint64_t position = WriteSamples(buffer, 0, 700);
+    uint64_t cursor = buffer.Snapshot();
+    EXPECT_EQ(cursor, 0, "snapshot starts at the first sample");
+
+    std::vector<int16_t> out(CAPACITY);
+    EXPECT_EQ(buffer.Read(cursor, out.data(), 500), 500, "read within the buffer");
+    EXPECT_EQ(Matches(out.data(), 0, 500), true, "first read matches");
+
+    // 写入跨过缓冲区末尾，读取也跨过末尾
+    position = WriteSamples(buffer, position, 600);
+    EXPECT_EQ(buffer.write_position(), 1300, "write position counts every sample");
+    EXPECT_EQ(buffer.Read(cursor, out.data(), CAPACITY), 800, "read across the wrap");
+    EXPECT_EQ(cursor, 1300, "cursor reaches the write position");
+    EXPECT_EQ(Matches(out.data(), 500, 800), true, "wrapped read matches");
+    EXPECT_EQ(buffer.Read(cursor, out.data(), CAPACITY), 0, "nothing left to read");
+}
+
+static void TestOverrunSkipsAhead() {
+    PcmRingBuffer buffer(CAPACITY);
+    uint64_t cursor = buffer.Snapshot();
+    uint64_t position = WriteSamples(buffer, 0, 2500);
+
+    // 落后超过容量的读取者跳到最早仍保存的采样
+    std::vector<int16_t> out(CAPACITY);
+    EXPECT_EQ(buffer.Snapshot(), position - CAPACITY, "snapshot is the oldest kept sample");
+    EXPECT_EQ(buffer.Read(cursor, out.data(), 100), 100, "overrun reader still reads");
+    EXPECT_EQ(cursor, position - CAPACITY + 100, "overrun reader skipped ahead");
+    EXPECT_EQ(Matches(out.data(), position - CAPACITY, 100), true, "skipped read matches");
+
+    // 一次写入超过容量时只保留最后 CAPACITY 个采样
+    position = WriteSamples(buffer, position, CAPACITY * 3 + 17);
+    cursor = 0;
+    EXPECT_EQ(buffer.Read(cursor, out.data(), CAPACITY), CAPACITY, "oversized write keeps a full buffer");
+    EXPECT_EQ(Matches(out.data(), position - CAPACITY, CAPACITY), true, "oversized write keeps the tail");
+}
+
+static void TestClear() {
+    PcmRingBuffer buffer(CAPACITY);
+    uint64_t position = WriteSamples(buffer, 0, 600);
+    uint64_t cursor = 100;
+    buffer.Clear();
+
+    std::vector<int16_t> out(CAPACITY);
+    EXPECT_EQ(buffer.Snapshot(), position, "snapshot after clear starts at the write position");
+    EXPECT_EQ(buffer.Read(cursor, out.data(), CAPACITY), 0, "cleared data is not readable");
+    EXPECT_EQ(cursor, position, "old cursor jumps past the cleared data");
+
+    position = WriteSamples(buffer, position, 300);
+    EXPECT_EQ(buffer.Read(cursor, out.data(), CAPACITY), 300, "only new data is read after clear");
+    EXPECT_EQ(Matches(out.data(), 600, 300), true, "data after clear matches");
+
+    // 写满之后最早的位置由容量决定，不再受 Clear 影响
+    position = WriteSamples(buffer, position, 1500);
+    EXPECT_EQ(buffer.Snapshot(), position - CAPACITY, "capacity limits the snapshot after clear");
+}
+
+static void TestSteadyStateDoesNotAllocate() {
+    size_t heap_before = host_heap_caps_allocations;
+    PcmRingBuffer buffer(CAPACITY);
+    EXPECT_EQ(host_heap_caps_allocations - heap_before, 1, "storage is allocated once in the constructor");
+
+    // 按设备上的方式连续写入一帧帧音频，同时有读取者跟随
+    std::vector<int16_t> frame(160);
+    std::vector<int16_t> out(CAPACITY);
+    for (size_t i = 0; i < frame.size(); i++) {
+        frame[i] = (int16_t)i;
+    }
+    uint64_t cursor = buffer.Snapshot();
+    heap_before = host_heap_caps_allocations;
+    size_t new_before = new_allocations;
+    for (int i = 0; i < 10000; i++) {
+        buffer.Write(frame.data(), frame.size());
+        if (i % 3 == 0) {
+            buffer.Read(cursor, out.data(), out.size());
+        }
+    }
+    buffer.Clear();
+    buffer.Snapshot();
+    EXPECT_EQ(host_heap_caps_allocations - heap_before, 0, "Write does not call heap_caps_malloc");
+    EXPECT_EQ(new_allocations - new_before, 0, "Write does not call operator new");
+}
+
+int main() {
+    TestWrapAround();
+    TestOverrunSkipsAhead();
+    TestClear();
+    TestSteadyStateDoesNotAllocate();
+
+    if (failures > 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("All checks passed\n");
+    return 0;
+}
@@ -0,0 +1,155 @@
+// PlayoutTimeline 的测试：输出流位置是回绕的 32 位计数，检查回绕前后的查找、截短与上行标记
+
+#include "audio_processing/playout_timeline.h"
+
+#include <cstdio>
+
+#define SAMPLE_RATE 24000
+#define FRAME_SAMPLES 1440
+
+static int failures = 0;
+
+#define EXPECT_EQ(actual, expected, message) do { \
+    long long a = (long long)(actual), e = (long long)(expected); \
+    if (a != e) { \
+        fprintf(stderr, "FAIL: %s: got %lld, expected %lld (%s:%d)\n", message, a, e, __FILE__, __LINE__); \
+        failures++; \
+    } \
+} while (0)
+
+// 从 start 开始连续登记 count 个下行帧，时间戳每帧加 60 毫秒
+static void AddFrames(PlayoutTimeline& timeline, uint32_t start, int count, uint32_t timestamp) {
+    for (int i = 0; i < count; i++) {
+        uint32_t end = start + FRAME_SAMPLES;
+        timeline.OnPlayout(end, FRAME_SAMPLES, SAMPLE_RATE, timestamp + i * 60);
+        start = end;
+    }
+}
+
+static void TestLookup(uint32_t start, const char* name) {
+    PlayoutTimeline timeline(16000);
+    AddFrames(timeline, start, 3, 1000);
+    char message[128];
+
+    snprintf(message, sizeof(message), "%s: before the first frame", name);
+    EXPECT_EQ(timeline.TimestampAt(start - 1), 0, message);
+    snprintf(message, sizeof(message), "%s: first sample", name);
+    EXPECT_EQ(timeline.TimestampAt(start), 1000, message);
+    snprintf(message, sizeof(message), "%s: middle of the first frame", name);
+    EXPECT_EQ(timeline.TimestampAt(start + 720), 1030, message);
+    snprintf(message, sizeof(message), "%s: second frame", name);
+    EXPECT_EQ(timeline.TimestampAt(start + FRAME_SAMPLES + 240), 1070, message);
+    // 已经播放过的帧被丢弃，倒退查询不再命中
+    snprintf(message, sizeof(message), "%s: played frames are dropped", name);
+    EXPECT_EQ(timeline.TimestampAt(start + 720), 0, message);
+    snprintf(message, sizeof(message), "%s: last sample", name);
+    EXPECT_EQ(timeline.TimestampAt(start + FRAME_SAMPLES * 3 - 1), 1000 + 120 + (FRAME_SAMPLES - 1) * 1000 / SAMPLE_RATE, message);
+    snprintf(message, sizeof(message), "%s: after the last frame", name);
+    EXPECT_EQ(timeline.TimestampAt(start + FRAME_SAMPLES * 3), 0, message);
+}
+
+static void TestWrapInsideFrame() {
+    // 一帧的中间跨过 2^32
+    PlayoutTimeline timeline(16000);
+    uint32_t start = 0xFFFFFF00;
+    AddFrames(timeline, start, 2, 5000);
+    EXPECT_EQ(timeline.TimestampAt(0xFFFFFF80), 5000 + 128 * 1000 / SAMPLE_RATE, "before the wrap");
+    EXPECT_EQ(timeline.TimestampAt(0x10), 5000 + 272 * 1000 / SAMPLE_RATE, "after the wrap");
+    EXPECT_EQ(timeline.TimestampAt(start + FRAME_SAMPLES), 5060, "next frame after the wrap");
+}
+
+static void TestRegisteredAhead() {
+    // 帧在写入之前登记，查询位置还没有到达时不能被丢弃
+    PlayoutTimeline timeline(16000);
+    uint32_t start = 0xFFFFF000;
+    AddFrames(timeline, start, 4, 2000);
+    EXPECT_EQ(timeline.TimestampAt(start - 4000), 0, "position before all registered frames");
+    EXPECT_EQ(timeline.TimestampAt(start + FRAME_SAMPLES * 3), 2180, "frames registered ahead are kept");
+}
+
+static void TestTruncate() {
+    PlayoutTimeline timeline(16000);
+    uint32_t start = 0xFFFFFE00;
+    AddFrames(timeline, start, 2, 3000);
+    // 第二帧只写入了 240 个采样，跨过 2^32
+    uint32_t second = start + FRAME_SAMPLES;
+    timeline.Truncate(second + 240);
+    EXPECT_EQ(timeline.TimestampAt(second + 100), 3060 + 100 * 1000 / SAMPLE_RATE, "written part of a truncated frame");
+    EXPECT_EQ(timeline.TimestampAt(second + 300), 0, "dropped part of a truncated frame");
+
+    // 一个采样都没写入时整帧丢弃，之前的帧不受影响
+    PlayoutTimeline dropped(16000);
+    AddFrames(dropped, start, 2, 3000);
+    dropped.Truncate(second);
+    EXPECT_EQ(dropped.TimestampAt(second - 1), 3000 + (FRAME_SAMPLES - 1) * 1000 / SAMPLE_RATE, "previous frame kept");
+    EXPECT_EQ(dropped.TimestampAt(second), 0, "frame with nothing written is dropped");
+
+    // 截短到帧尾之后不改变记录
+    PlayoutTimeline unchanged(16000);
+    AddFrames(unchanged, start, 1, 3000);
+    unchanged.Truncate(start + FRAME_SAMPLES + 10);
+    EXPECT_EQ(unchanged.TimestampAt(start + FRAME_SAMPLES - 1), 3000 + (FRAME_SAMPLES - 1) * 1000 / SAMPLE_RATE, "truncate past the end");
+}
+
+static void TestZeroTimestamp() {
+    PlayoutTimeline timeline(16000);
+    timeline.OnPlayout(FRAME_SAMPLES, FRAME_SAMPLES, SAMPLE_RATE, 0);
+    EXPECT_EQ(timeline.TimestampAt(100), 0, "frame without a server timestamp");
+}
+
+static void TestMarkLimit() {
+    // 超出记录上限时丢弃最早的帧
+    PlayoutTimeline timeline(16000);
+    AddFrames(timeline, 0, 40, 1000);
+    EXPECT_EQ(timeline.TimestampAt(0), 0, "oldest frames are dropped when full");
+    EXPECT_EQ(timeline.TimestampAt(FRAME_SAMPLES * 39), 1000 + 39 * 60, "newest frame is kept");
+}
+
+static void TestUplink() {
+    PlayoutTimeline timeline(16000);
+    // 三块 10 毫秒的采集，第二块采集时没有在播放
+    timeline.OnCapture(160, 4000, 1000000, 50);
+    timeline.OnCapture(160, 0, 1010000, 50);
+    timeline.OnCapture(160, 4020, 1020000, 50);
+
+    auto tag = timeline.TakeUplink(80, 1040000);
+    EXPECT_EQ(tag.timestamp, 4000, "first uplink frame");
+    EXPECT_EQ(tag.loopback_delay_ms, 50 + 40, "loopback delay of the first frame");
+
+    // 从第一块的中间开始，跨越到第二块
+    tag = timeline.TakeUplink(160, 1045000);
+    EXPECT_EQ(tag.timestamp, 4005, "uplink frame starting inside a capture block");
+    EXPECT_EQ(tag.loopback_delay_ms, 50 + 40, "loopback delay inside a capture block");
+
+    tag = timeline.TakeUplink(80, 1050000);
+    EXPECT_EQ(tag.timestamp, 0, "capture block without playback");
+
+    tag = timeline.TakeUplink(160, 1060000);
+    EXPECT_EQ(tag.timestamp, 4020, "third capture block");
+    tag = timeline.TakeUplink(160, 1070000);
+    EXPECT_EQ(tag.timestamp, 0, "no capture blocks left");
+    EXPECT_EQ(tag.loopback_delay_ms, 0, "no loopback delay without capture blocks");
+
+    timeline.OnCapture(160, 4100, 2000000, 50);
+    timeline.ResetCapture();
+    EXPECT_EQ(timeline.TakeUplink(160, 2010000).timestamp, 0, "capture blocks are dropped on reset");
+}
+
+int main() {
+    TestLookup(0, "from zero");
+    TestLookup(0xFFFFFFFF - FRAME_SAMPLES, "across the wrap");
+    TestLookup(0xFFFFFFFF - FRAME_SAMPLES * 3 + 1, "ending at the wrap");
+    TestWrapInsideFrame();
+    TestRegisteredAhead();
+    TestTruncate();
+    TestZeroTimestamp();
+    TestMarkLimit();
+    TestUplink();
+
+    if (failures > 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("All checks passed\n");
+    return 0;
+}
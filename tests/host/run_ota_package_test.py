@@ -0,0 +1,108 @@
+#! /usr/bin/env python3
+"""
+生成测试固件，用 scripts/ota_package.py 打包后交给 ota_package_test 用设备端解码器还原。
+
+  python run_ota_package_test.py <ota_package_test 可执行文件> <工作目录>
+"""
+import os
+import sys
+import random
+import subprocess
+
+SCRIPT = os.path.join(os.path.dirname(__file__), "..", "..", "scripts", "ota_package.py")
+
+
+def make_base(rng, size):
+    # 类似固件：可压缩的代码段与不可压缩的数据段交替
+    out = bytearray()
+    while len(out) < size:
+        if rng.random() < 0.5:
+            word = bytes(rng.randrange(256) for _ in range(rng.randrange(4, 16)))
+            out.extend(word * rng.randrange(8, 64))
+        else:
+            out.extend(rng.randbytes(rng.randrange(256, 4096)))
+    return bytes(out[:size])
+
+
+def make_image(rng, base):
+    # 在旧固件的基础上修改、插入和删除若干段，产生 COPY 与 INSERT 指令
+    image = bytearray(base)
+    for _ in range(40):
+        pos = rng.randrange(len(image))
+        action = rng.random()
+        if action < 0.4:
+            image[pos:pos + rng.randrange(1, 64)] = rng.randbytes(rng.randrange(1, 64))
+        elif action < 0.7:
+            image[pos:pos] = rng.randbytes(rng.randrange(1, 2048))
+        else:
+            del image[pos:pos + rng.randrange(1, 2048)]
+    return bytes(image)
+
+
+def write(path, data):
+    with open(path, "wb") as f:
+        f.write(data)
+
+
+def create(image, output, base=None, compress=True):
+    args = [sys.executable, SCRIPT, "create", image, "-o", output]
+    if base:
+        args += ["--base", base]
+    if not compress:
+        args.append("--no-compress")
+    subprocess.run(args, check=True, stdout=subprocess.DEVNULL)
+
+
+def main():
+    tester, workdir = sys.argv[1], sys.argv[2]
+    os.makedirs(workdir, exist_ok=True)
+    rng = random.Random(20240611)
+
+    # 大于 32KB 字典数倍，解压输出会多次绕回环形字典开头
+    base = make_base(rng, 300 * 1024)
+    image = make_image(rng, base)
+    other = make_base(rng, len(base))
+    paths = {name: os.path.join(workdir, name) for name in ("base.bin", "image.bin", "other.bin")}
+    write(paths["base.bin"], base)
+    write(paths["image.bin"], image)
+    write(paths["other.bin"], other)
+
+    cases = []
+    for name, use_base, compress in (("full.xzo", False, True), ("full-raw.xzo", False, False),
+                                     ("delta.xzo", True, True), ("delta-raw.xzo", True, False)):
+        path = os.path.join(workdir, name)
+        create(paths["image.bin"], path, paths["base.bin"] if use_base else None, compress)
+        cases.append(([path, paths["image.bin"], "--base", paths["base.bin"]], False))
+
+    # 异常的包必须被拒绝：基准固件不同、被截断、压缩流后面带有多余数据仍应成功
+    delta = os.path.join(workdir, "delta.xzo")
+    cases.append(([delta, paths["image.bin"], "--base", paths["other.bin"]], True))
+    with open(delta, "rb") as f:
+        delta_data = f.read()
+    for name, data, expect_fail in (("truncated.xzo", delta_data[:len(delta_data) * 2 // 3], True),
+                                    ("trailing.xzo", delta_data + b"\0" * 100, False)):
+        path = os.path.join(workdir, name)
+        write(path, data)
+        cases.append(([path, paths["image.bin"], "--base", paths["base.bin"]], expect_fail))
+
+    # 差分中复制越界：手工构造一条超出基准固件范围的 COPY 指令
+    sys.path.insert(0, os.path.dirname(SCRIPT))
+    import ota_package
+    import struct
+    header = struct.pack(ota_package.HEADER_FORMAT, ota_package.MAGIC, ota_package.FLAG_DELTA, 16,
+                         len(base), ota_package.hashlib.sha256(base).digest())
+    path = os.path.join(workdir, "copy-out-of-range.xzo")
+    write(path, header + struct.pack("<BII", ota_package.OP_COPY, len(base) - 8, 16) + bytes([ota_package.OP_END]))
+    cases.append(([path, paths["image.bin"], "--base", paths["base.bin"]], True))
+
+    failed = 0
+    for args, expect_fail in cases:
+        command = [tester] + args + (["--expect-fail"] if expect_fail else [])
+        if subprocess.run(command, stderr=subprocess.DEVNULL if expect_fail else None).returncode != 0:
+            failed += 1
+    print("%d/%d cases passed" % (len(cases) - failed, len(cases)))
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
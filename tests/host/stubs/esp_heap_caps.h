@@ -0,0 +1,19 @@
+#ifndef HOST_ESP_HEAP_CAPS_H
+#define HOST_ESP_HEAP_CAPS_H
+
+#include <cstdlib>
+
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+// 累计的分配次数，测试用来检查稳态路径不再分配内存
+inline size_t host_heap_caps_allocations = 0;
+
+inline void* heap_caps_malloc(size_t size, int caps) {
+    host_heap_caps_allocations++;
+    return malloc(size);
+}
+inline void heap_caps_free(void* ptr) { free(ptr); }
+
+#endif // HOST_ESP_HEAP_CAPS_H
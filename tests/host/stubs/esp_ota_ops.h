@@ -0,0 +1,11 @@
+#ifndef HOST_ESP_OTA_OPS_H
+#define HOST_ESP_OTA_OPS_H
+
+#include "esp_partition.h"
+
+const esp_partition_t* esp_ota_get_running_partition(void);
+
+// 测试用：设置当前运行分区的内容，data 需要在解码期间保持有效
+void host_set_running_partition(const uint8_t* data, size_t size);
+
+#endif // HOST_ESP_OTA_OPS_H
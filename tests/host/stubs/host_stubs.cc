@@ -0,0 +1,82 @@
+#include "esp_ota_ops.h"
+#include "rom/miniz.h"
+
+#include <cstring>
+
+static esp_partition_t running_partition = { 0x10000, 0, "ota_0" };
+static const uint8_t* running_data = nullptr;
+
+void host_set_running_partition(const uint8_t* data, size_t size) {
+    running_data = data;
+    running_partition.size = size;
+}
+
+const esp_partition_t* esp_ota_get_running_partition(void) {
+    return &running_partition;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t src_offset, void* dst, size_t size) {
+    if (partition != &running_partition || src_offset > partition->size || size > partition->size - src_offset) {
+        return ESP_FAIL;
+    }
+    memcpy(dst, running_data + src_offset, size);
+    return ESP_OK;
+}
+
+enum {
+    kInflateIdle,
+    kInflateRunning,
+    kInflateFinished,
+};
+
+void tinfl_init(tinfl_decompressor* r) {
+    r->state = kInflateIdle;
+}
+
+tinfl_status tinfl_decompress(tinfl_decompressor* r, const mz_uint8* pIn_buf_next, size_t* pIn_buf_size,
+    mz_uint8* pOut_buf_start, mz_uint8* pOut_buf_next, size_t* pOut_buf_size, const mz_uint32 decomp_flags) {
+    size_t in_size = *pIn_buf_size;
+    size_t out_size = *pOut_buf_size;
+    *pIn_buf_size = 0;
+    *pOut_buf_size = 0;
+    // 环形字典：输出位置必须在字典内，且一次写入不能越过字典末尾
+    if (pOut_buf_next < pOut_buf_start || pOut_buf_next + out_size > pOut_buf_start + TINFL_LZ_DICT_SIZE) {
+        return TINFL_STATUS_BAD_PARAM;
+    }
+    if (r->state == kInflateFinished) {
+        return TINFL_STATUS_DONE;
+    }
+    if (r->state == kInflateIdle) {
+        memset(&r->stream, 0, sizeof(r->stream));
+        if (inflateInit2(&r->stream, -15) != Z_OK) {
+            return TINFL_STATUS_FAILED;
+        }
+        r->state = kInflateRunning;
+    }
+
+    r->stream.next_in = (Bytef*)pIn_buf_next;
+    r->stream.avail_in = in_size;
+    r->stream.next_out = pOut_buf_next;
+    r->stream.avail_out = out_size;
+    int ret = out_size > 0 ? inflate(&r->stream, Z_NO_FLUSH) : Z_BUF_ERROR;
+    *pIn_buf_size = in_size - r->stream.avail_in;
+    *pOut_buf_size = out_size - r->stream.avail_out;
+
+    if (ret == Z_STREAM_END) {
+        inflateEnd(&r->stream);
+        r->state = kInflateFinished;
+        return TINFL_STATUS_DONE;
+    }
+    if (ret != Z_OK && ret != Z_BUF_ERROR) {
+        inflateEnd(&r->stream);
+        r->state = kInflateFinished;
+        return TINFL_STATUS_FAILED;
+    }
+    if (r->stream.avail_out == 0) {
+        return TINFL_STATUS_HAS_MORE_OUTPUT;
+    }
+    if (!(decomp_flags & TINFL_FLAG_HAS_MORE_INPUT)) {
+        return TINFL_STATUS_FAILED_CANNOT_MAKE_PROGRESS;
+    }
+    return TINFL_STATUS_NEEDS_MORE_INPUT;
+}
@@ -0,0 +1,36 @@
+#ifndef HOST_ROM_MINIZ_H
+#define HOST_ROM_MINIZ_H
+
+#include <cstddef>
+#include <cstdint>
+#include <zlib.h>
+
+// 主机测试用：按 ROM 中 tinfl 的接口约定，用 zlib 的 raw inflate 实现。
+// 输出缓冲区必须是 TINFL_LZ_DICT_SIZE 的环形字典，写入不能越过字典末尾，违反时返回失败，
+// 用来检查解码器对环形字典的使用是否正确。
+typedef uint8_t mz_uint8;
+typedef uint32_t mz_uint32;
+
+#define TINFL_LZ_DICT_SIZE 32768
+#define TINFL_FLAG_HAS_MORE_INPUT 2
+
+typedef enum {
+    TINFL_STATUS_FAILED_CANNOT_MAKE_PROGRESS = -4,
+    TINFL_STATUS_BAD_PARAM = -3,
+    TINFL_STATUS_ADLER32_MISMATCH = -2,
+    TINFL_STATUS_FAILED = -1,
+    TINFL_STATUS_DONE = 0,
+    TINFL_STATUS_NEEDS_MORE_INPUT = 1,
+    TINFL_STATUS_HAS_MORE_OUTPUT = 2,
+} tinfl_status;
+
+typedef struct {
+    z_stream stream;
+    int state;
+} tinfl_decompressor;
+
+void tinfl_init(tinfl_decompressor* r);
+tinfl_status tinfl_decompress(tinfl_decompressor* r, const mz_uint8* pIn_buf_next, size_t* pIn_buf_size,
+    mz_uint8* pOut_buf_start, mz_uint8* pOut_buf_next, size_t* pOut_buf_size, const mz_uint32 decomp_flags);
+
+#endif // HOST_ROM_MINIZ_H
@@ -0,0 +1,248 @@
+// WakeWordGate 的测试与调参。
+//
+// 不带参数时用合成音频检查门限的打开、补发、保持、噪声底跟踪与 Reset；
+// 带 --pcm 时逐块处理录制的 16kHz 16 位交错 PCM，输出每块的幅度、噪声底与门限状态：
+//   wake_word_gate_test --pcm recorded.raw [--channels N] [--chunk 512] [--ratio 300] [--min-level 150]
+//       [--lookback 4800] [--hangover 16000]
+
+#include "audio_processing/wake_word_gate.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <vector>
+
+#define SAMPLE_RATE 16000
+#define CHUNK_SAMPLES 512
+#define LOOKBACK_SAMPLES 4800
+
+static int failures = 0;
+
+#define EXPECT(condition, message) do { \
+    if (!(condition)) { \
+        fprintf(stderr, "FAIL: %s (%s:%d)\n", message, __FILE__, __LINE__); \
+        failures++; \
+    } \
+} while (0)
+
+// 合成的声源：底噪上叠加低频（风扇）、浊音（说话）或高频（嘶声）成分
+class Source {
+public:
+    Source(int channels = 1) : channels_(channels), random_(11) {}
+
+    // 每声道 CHUNK_SAMPLES 个采样，signal_channel 之外的声道只有底噪
+    std::vector<int16_t> Chunk(int noise, int hum = 0, int voice = 0, int hiss = 0, int signal_channel = 0) {
+        std::normal_distribution<double> gaussian(0, 1);
+        std::vector<int16_t> data(CHUNK_SAMPLES * channels_);
+        for (int i = 0; i < CHUNK_SAMPLES; i++) {
+            double t = (double)(position_ + i) / SAMPLE_RATE;
+            for (int c = 0; c < channels_; c++) {
+                double value = noise * gaussian(random_);
+                if (c == signal_channel) {
+                    value += hum * sin(2 * M_PI * 120 * t);
+                    // 基频 180Hz 带两个谐波，按 4Hz 的音节包络起伏
+                    double envelope = 0.6 + 0.4 * sin(2 * M_PI * 4 * t);
+                    value += voice * envelope * (sin(2 * M_PI * 180 * t) + 0.5 * sin(2 * M_PI * 360 * t) + 0.25 * sin(2 * M_PI * 540 * t));
+                    value += hiss * gaussian(random_);
+                }
+                data[i * channels_ + c] = (int16_t)std::max(-32768.0, std::min(32767.0, value));
+            }
+        }
+        position_ += CHUNK_SAMPLES;
+        return data;
+    }
+
+private:
+    int channels_;
+    std::mt19937 random_;
+    int64_t position_ = 0;
+};
+
+struct Result {
+    int passed = 0;
+    size_t output_samples = 0;
+};
+
+static Result FeedChunks(WakeWordGate& gate, Source& source, int chunks, int noise, int hum = 0, int voice = 0, int hiss = 0) {
+    Result result;
+    for (int i = 0; i < chunks; i++) {
+        auto data = source.Chunk(noise, hum, voice, hiss);
+        if (gate.Feed(data, [&result](const std::vector<int16_t>& output) { result.output_samples += output.size(); })) {
+            result.passed++;
+        }
+    }
+    return result;
+}
+
+static int SecondsToChunks(double seconds) {
+    return (int)(seconds * SAMPLE_RATE / CHUNK_SAMPLES);
+}
+
+static void TestQuiet() {
+    WakeWordGate gate(1, LOOKBACK_SAMPLES);
+    Source source;
+    auto result = FeedChunks(gate, source, SecondsToChunks(10), 30);
+    EXPECT(result.passed == 0 && result.output_samples == 0, "background noise must keep the gate closed");
+    EXPECT(!gate.is_open(), "gate is closed in a quiet room");
+}
+
+static void TestVoiceOpensWithLookback() {
+    WakeWordGate gate(1, LOOKBACK_SAMPLES);
+    Source source;
+    FeedChunks(gate, source, SecondsToChunks(3), 30);
+    auto result = FeedChunks(gate, source, 1, 30, 0, 3000);
+    EXPECT(gate.is_open(), "voice opens the gate");
+    // 回看按块保存，补发的长度向上取整到整块
+    int lookback_chunks = (LOOKBACK_SAMPLES + CHUNK_SAMPLES - 1) / CHUNK_SAMPLES;
+    EXPECT(result.output_samples == (size_t)(lookback_chunks + 1) * CHUNK_SAMPLES, "lookback is replayed before the first open chunk");
+}
+
+static void TestHangover() {
+    WakeWordGate gate(1, LOOKBACK_SAMPLES);
+    gate.SetHangover(SAMPLE_RATE / 2);
+    Source source;
+    FeedChunks(gate, source, SecondsToChunks(3), 30);
+    FeedChunks(gate, source, SecondsToChunks(1), 30, 0, 3000);
+    // 停顿期间按保持时间继续输出，之后关闭
+    auto pause = FeedChunks(gate, source, SecondsToChunks(2), 30);
+    int hangover_chunks = (SAMPLE_RATE / 2 + CHUNK_SAMPLES - 1) / CHUNK_SAMPLES;
+    EXPECT(pause.passed >= hangover_chunks - 1 && pause.passed <= hangover_chunks, "gate stays open for the hangover");
+    EXPECT(!gate.is_open(), "gate closes after the hangover");
+}
+
+static void TestHiss() {
+    WakeWordGate gate(1, LOOKBACK_SAMPLES);
+    Source source;
+    FeedChunks(gate, source, SecondsToChunks(3), 30);
+    auto result = FeedChunks(gate, source, SecondsToChunks(5), 30, 0, 0, 2000);
+    EXPECT(result.passed == 0, "loud hiss with a high zero crossing rate is not speech");
+}
+
+static void TestSteadyNoiseIsAbsorbed() {
+    // 安静中突然出现的稳态低频噪声，能量远高于噪声底且过零率低，一开始会打开门限
+    WakeWordGate gate(1, LOOKBACK_SAMPLES);
+    gate.SetHangover(SAMPLE_RATE / 2);
+    Source source;
+    FeedChunks(gate, source, SecondsToChunks(3), 30);
+    int quiet_floor = gate.noise_floor();
+    FeedChunks(gate, source, 1, 30, 1500);
+    EXPECT(gate.is_open(), "a sudden fan opens the gate at first");
+
+    // 噪声底在打开期间也会缓慢上升，门限最终关闭并保持关闭
+    FeedChunks(gate, source, SecondsToChunks(30), 30, 1500);
+    EXPECT(gate.noise_floor() > quiet_floor * 3, "noise floor follows a steady fan");
+    auto result = FeedChunks(gate, source, SecondsToChunks(10), 30, 1500);
+    EXPECT(result.passed == 0, "gate stays closed once the fan is background");
+
+    // 风扇之上的说话声仍然能打开门限
+    FeedChunks(gate, source, 2, 30, 1500, 8000);
+    EXPECT(gate.is_open(), "voice above the fan still opens the gate");
+}
+
+static void TestLongSpeechKeepsOpen() {
+    // 噪声底在打开期间上升很慢，连续说几秒话不会把门限关掉
+    WakeWordGate gate(1, LOOKBACK_SAMPLES);
+    Source source;
+    FeedChunks(gate, source, SecondsToChunks(3), 30);
+    auto result = FeedChunks(gate, source, SecondsToChunks(5), 30, 0, 3000);
+    EXPECT(result.passed == SecondsToChunks(5), "gate stays open during continuous speech");
+}
+
+static void TestReferenceChannelIgnored() {
+    // 只分析第 0 声道，播放参考声道上的声音不会打开门限
+    WakeWordGate gate(2, LOOKBACK_SAMPLES);
+    Source source(2);
+    int passed = 0;
+    for (int i = 0; i < SecondsToChunks(5); i++) {
+        auto data = source.Chunk(30, 0, i < SecondsToChunks(2) ? 0 : 3000, 0, 1);
+        if (gate.Feed(data, [](const std::vector<int16_t>&) {})) {
+            passed++;
+        }
+    }
+    EXPECT(passed == 0, "sound on the reference channel is ignored");
+}
+
+static void TestReset() {
+    WakeWordGate gate(1, LOOKBACK_SAMPLES);
+    gate.SetHangover(SAMPLE_RATE);
+    Source source;
+    FeedChunks(gate, source, SecondsToChunks(3), 30);
+    FeedChunks(gate, source, 2, 30, 0, 3000);
+    EXPECT(gate.is_open(), "gate is open before reset");
+    gate.Reset();
+    auto quiet = FeedChunks(gate, source, 1, 30);
+    EXPECT(!gate.is_open() && quiet.passed == 0, "reset closes the gate without waiting for the hangover");
+    // Reset 之后只补发新的回看音频
+    auto result = FeedChunks(gate, source, 1, 30, 0, 3000);
+    EXPECT(result.output_samples == 2 * CHUNK_SAMPLES, "reset drops the old lookback");
+}
+
+static int RunRecorded(int argc, char** argv) {
+    const char* path = nullptr;
+    int channels = 1, chunk = CHUNK_SAMPLES, ratio = 300, min_level = 150;
+    int lookback = LOOKBACK_SAMPLES, hangover = SAMPLE_RATE;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--pcm") == 0) {
+            path = argv[i + 1];
+        } else if (strcmp(argv[i], "--channels") == 0) {
+            channels = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--chunk") == 0) {
+            chunk = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--ratio") == 0) {
+            ratio = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--min-level") == 0) {
+            min_level = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--lookback") == 0) {
+            lookback = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--hangover") == 0) {
+            hangover = atoi(argv[i + 1]);
+        }
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return 2;
+    }
+    WakeWordGate gate(channels, lookback);
+    gate.SetThreshold(ratio, min_level);
+    gate.SetHangover(hangover);
+
+    std::vector<int16_t> data(chunk * channels);
+    int count = 0;
+    while (file.read((char*)data.data(), data.size() * sizeof(int16_t))) {
+        bool passed = gate.Feed(data, [](const std::vector<int16_t>&) {});
+        printf("%8.2fs level %5d floor %5d%s\n", (double)count * chunk / SAMPLE_RATE, gate.level(), gate.noise_floor(), passed ? " OPEN" : "");
+        data.resize(chunk * channels);
+        count++;
+    }
+    if (count > 0) {
+        printf("%u/%u chunks passed\n", gate.passed_chunks(), gate.total_chunks());
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        return RunRecorded(argc, argv);
+    }
+
+    TestQuiet();
+    TestVoiceOpensWithLookback();
+    TestHangover();
+    TestHiss();
+    TestSteadyNoiseIsAbsorbed();
+    TestLongSpeechKeepsOpen();
+    TestReferenceChannelIgnored();
+    TestReset();
+
+    if (failures > 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("All checks passed\n");
+    return 0;
+}